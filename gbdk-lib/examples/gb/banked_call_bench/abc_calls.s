@@ -0,0 +1,81 @@
+	;; Loops timing ___sdcc_bcall_abc against a plain CALL of the same
+	;; routine, with A = bank and BC = address, and the arguments in DE
+	;; and HL. D counts the calls, which the routine leaves alone.
+
+	BENCH_CALLS	= 40		; Also in banked_call_bench.h
+	TIMA		= 0xFF05	; Timer counter
+
+	.globl	___sdcc_bcall_abc
+
+	.area	_CODE_1
+
+	;; HL += DE, A = 1, in bank 1
+_add_abc::
+	add	hl,de
+	ld	a,#1
+	ret
+
+	;; UINT8 abc_same_loop(void)
+	;; Bank 1 to bank 1, called from time_same_abc()
+_abc_same_loop::
+	push	bc
+	ld	d,#BENCH_CALLS
+	ld	hl,#0
+	xor	a
+	ld	(#TIMA),a
+1$:
+	ld	a,#1
+	ld	bc,#_add_abc
+	call	___sdcc_bcall_abc
+	dec	d
+	jr	nz,1$
+	ld	a,(#TIMA)
+	ld	e,a
+	pop	bc
+	ret
+
+	.area	_CODE
+
+	;; Same as _add_abc, in bank 0
+_add_plain::
+	add	hl,de
+	ld	a,#1
+	ret
+
+	;; UINT8 time_abc_plain(void)
+	;; Plain CALL, to take off the cost of the loop and the routine
+_time_abc_plain::
+	push	bc
+	ld	d,#BENCH_CALLS
+	ld	hl,#0
+	xor	a
+	ld	(#TIMA),a
+1$:
+	ld	a,#1
+	ld	bc,#_add_plain
+	call	_add_plain
+	dec	d
+	jr	nz,1$
+	ld	a,(#TIMA)
+	ld	e,a
+	pop	bc
+	ret
+
+	;; UINT8 time_abc_other(void)
+	;; Bank 0 to bank 1
+_time_abc_other::
+	push	bc
+	ld	d,#BENCH_CALLS
+	ld	hl,#0
+	xor	a
+	ld	(#TIMA),a
+1$:
+	ld	a,#1
+	ld	bc,#_add_abc
+	call	___sdcc_bcall_abc
+	dec	d
+	jr	nz,1$
+	ld	a,(#TIMA)
+	ld	e,a
+	pop	bc
+	ret
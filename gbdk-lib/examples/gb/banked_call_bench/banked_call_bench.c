@@ -0,0 +1,67 @@
+/* Measures the cost of banked calls over a plain CALL, with the timer
+   counting every 16 M-cycles over BENCH_CALLS calls of each kind:
+   C BANKED functions through ___sdcc_bcall, and asm routines taking
+   their arguments in registers through ___sdcc_bcall_abc, each from
+   another bank and from the same bank.
+ */
+#include <gb/gb.h>
+#include <stdio.h>
+#include "banked_call_bench.h"
+
+void empty(void)
+{
+}
+
+UINT8 time_plain(void)
+{
+  UINT8 i;
+
+  TIMA_REG = 0;
+  for (i = 0; i != BENCH_CALLS; i++)
+    empty();
+  return TIMA_REG;
+}
+
+UINT8 time_banked(void)
+{
+  UINT8 i;
+
+  TIMA_REG = 0;
+  for (i = 0; i != BENCH_CALLS; i++)
+    far_empty();
+  return TIMA_REG;
+}
+
+/* Prints the M-cycles per call over the plain loop, to a tenth */
+void report(const char *what, UINT8 ticks, UINT8 plain)
+{
+  UINT16 tenths = (UINT16)(UINT8)(ticks - plain) * 160U / BENCH_CALLS;
+
+  printf("%s%u.%u\n", what, tenths / 10U, tenths % 10U);
+}
+
+void main(void)
+{
+  UINT8 plain, other, same_plain, same, abc_plain, abc_other, abc_same;
+
+  TMA_REG = 0x00U;
+  TAC_REG = 0x06U;  /* 65536 Hz, every 16 M-cycles */
+
+  disable_interrupts();
+  plain = time_plain();
+  other = time_banked();
+  same_plain = time_same_plain();
+  same = time_same_banked();
+  abc_plain = time_abc_plain();
+  abc_other = time_abc_other();
+  abc_same = time_same_abc();
+  enable_interrupts();
+
+  printf("Banked call cost\nover a plain CALL,\nin M-cycles\n\n");
+  printf("___sdcc_bcall\n");
+  report(" other bank ", other, plain);
+  report(" same bank  ", same, same_plain);
+  printf("___sdcc_bcall_abc\n");
+  report(" other bank ", abc_other, abc_plain);
+  report(" same bank  ", abc_same, abc_plain);
+}
@@ -0,0 +1,19 @@
+#ifndef _BANKED_CALL_BENCH_H
+#define _BANKED_CALL_BENCH_H
+
+#include <gb/gb.h>
+
+/* Calls timed in each loop, also in abc_calls.s */
+#define BENCH_CALLS 40
+
+/* Bank 1, far.c */
+void far_empty(void) BANKED;
+UINT8 time_same_plain(void) BANKED;
+UINT8 time_same_banked(void) BANKED;
+UINT8 time_same_abc(void) BANKED;
+
+/* Bank 0, abc_calls.s */
+UINT8 time_abc_plain(void);
+UINT8 time_abc_other(void);
+
+#endif /* _BANKED_CALL_BENCH_H */
@@ -0,0 +1,39 @@
+/* Bank 1 side of the benchmark: the banked function, and the loops
+   calling it from its own bank */
+#include <gb/gb.h>
+#include "banked_call_bench.h"
+
+UINT8 abc_same_loop(void);  /* abc_calls.s, in this bank */
+
+void far_empty(void) BANKED
+{
+}
+
+void same_empty(void)
+{
+}
+
+UINT8 time_same_plain(void) BANKED
+{
+  UINT8 i;
+
+  TIMA_REG = 0;
+  for (i = 0; i != BENCH_CALLS; i++)
+    same_empty();
+  return TIMA_REG;
+}
+
+UINT8 time_same_banked(void) BANKED
+{
+  UINT8 i;
+
+  TIMA_REG = 0;
+  for (i = 0; i != BENCH_CALLS; i++)
+    far_empty();
+  return TIMA_REG;
+}
+
+UINT8 time_same_abc(void) BANKED
+{
+  return abc_same_loop();
+}
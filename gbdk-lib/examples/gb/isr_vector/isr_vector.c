@@ -0,0 +1,40 @@
+/* Counts timer interrupts with a handler jumped to straight from the
+   TIM vector, instead of one added with add_TIM.
+ */
+#include <gb/gb.h>
+#include <stdio.h>
+
+UINT16 tim_cnt;
+
+void tim(void) __interrupt
+{
+  tim_cnt++;
+}
+
+ISR_VECTOR(TIM, tim);
+
+void main(void)
+{
+  UINT16 cnt;
+
+  printf("Direct TIM vector\n\n");
+
+  CRITICAL {
+    tim_cnt = 0;
+  }
+
+  // Set TMA to divide clock by 0x100
+  TMA_REG = 0x00U;
+  // Set clock to 4096 Hertz
+  TAC_REG = 0x04U;
+  // Handle VBL and TIM interrupts
+  set_interrupts(VBL_IFLAG | TIM_IFLAG);
+
+  while(1) {
+    CRITICAL {
+      cnt = tim_cnt;
+    }
+    printf(" TIM %u\n", cnt);
+    delay(1000UL);
+  }
+}
@@ -0,0 +1,52 @@
+/* Waves the background in bands of four lines and fades the palette
+   down the screen with a table of runs, building each frame's table
+   while the last one is shown.
+ */
+#include <gb/gb.h>
+#include <gb/scanline_fx.h>
+#include <stdio.h>
+
+#define BAND_LINES 4
+#define BANDS (144 / BAND_LINES)
+
+const INT8 wave[32] = {
+  0, 1, 2, 3, 4, 5, 5, 6, 6, 6, 5, 5, 4, 3, 2, 1,
+  0, -1, -2, -3, -4, -5, -5, -6, -6, -6, -5, -5, -4, -3, -2, -1
+};
+
+const UINT8 fade[4] = { 0xE4, 0x90, 0x40, 0x00 };
+
+scanline_run_t table[2][BANDS];
+
+void build(scanline_run_t *t, UINT8 phase)
+{
+  UINT8 band;
+
+  for (band = 0; band < BANDS; band++, t++) {
+    t->scx = wave[(UINT8)(band + phase) & 0x1F];
+    t->scy = 0;
+    t->wx = 167;                /* Window off the screen */
+    t->bgp = fade[band / (BANDS / 4)];
+    t->lines = BAND_LINES;
+  }
+}
+
+void main(void)
+{
+  UINT8 cur = 0, phase = 0;
+
+  printf("Scanline effects\n\n");
+  printf("SCX waves and BGP\nfades down the\nscreen, set from\na table of runs.");
+
+  build(table[0], 0);
+  disable_interrupts();
+  scanline_fx_start(table[0]);
+  enable_interrupts();
+
+  while (1) {
+    wait_vbl_done();
+    cur ^= 1;
+    build(table[cur], ++phase);
+    scanline_fx_show(table[cur]);
+  }
+}
@@ -0,0 +1,82 @@
+/* Scrolls over a 1024x768 pixel map in ROM bank 1 in all eight
+   directions, and times each scroll_map_move() with the divider
+   register (one tick is 256 cycles).
+ */
+#include <gb/gb.h>
+#include <gb/scroll_map.h>
+#include <stdio.h>
+
+#define MAP_W           128
+#define MAP_H           96
+#define SPEED           8       /* Pixels per frame, up to 8 */
+#define FRAMES          64      /* Frames in each direction */
+
+extern const UINT8 world_map[];
+
+const INT8 dir_x[] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+const INT8 dir_y[] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+UINT8 tile[16];
+
+/* Tiles 0, 2, 4, 6 in shades 0 to 3, and 1, 3, 5, 7 with a black
+   line along the top and left */
+void make_tiles(void)
+{
+  UINT8 shade, i, lo, hi;
+
+  for (shade = 0; shade < 4; shade++) {
+    lo = (shade & 1) ? 0xFF : 0x00;
+    hi = (shade & 2) ? 0xFF : 0x00;
+    for (i = 0; i < 16; i += 2) {
+      tile[i] = lo;
+      tile[i + 1] = hi;
+    }
+    set_bkg_data(shade * 2, 1, tile);
+    tile[0] = tile[1] = 0xFF;
+    for (i = 2; i < 16; i++)
+      tile[i] |= 0x80;
+    set_bkg_data(shade * 2 + 1, 1, tile);
+  }
+}
+
+void main(void)
+{
+  INT16 x = 0, y = 0;
+  UINT8 d, f, t, ticks, max_ticks = 0;
+  UINT16 total = 0, moves = 0;
+
+  disable_interrupts();
+  DISPLAY_OFF;
+  make_tiles();
+  scroll_map_set(world_map, MAP_W, MAP_H, 1, x, y);
+  SHOW_BKG;
+  DISPLAY_ON;
+  enable_interrupts();
+
+  for (d = 0; d < 8; d++) {
+    for (f = 0; f < FRAMES; f++) {
+      x += dir_x[d] * SPEED;
+      y += dir_y[d] * SPEED;
+      if (x < 0) x = 0;
+      if (x > MAP_W * 8 - 160) x = MAP_W * 8 - 160;
+      if (y < 0) y = 0;
+      if (y > MAP_H * 8 - 144) y = MAP_H * 8 - 144;
+
+      wait_vbl_done();
+      t = DIV_REG;
+      scroll_map_move(x, y);
+      ticks = DIV_REG - t;
+
+      if (ticks > max_ticks)
+        max_ticks = ticks;
+      total += ticks;
+      moves++;
+    }
+  }
+
+  move_bkg(0, 0);
+  printf("%u moves at %u px\n", moves, SPEED);
+  printf("max %u cycles\n", max_ticks * 256U);
+  printf("avg %u cycles\n", (UINT16)(total * 256UL / moves));
+  printf("VBlank %u cycles\n", 4560U);
+}
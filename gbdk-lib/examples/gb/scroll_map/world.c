@@ -0,0 +1,25 @@
+/* A 128x96 tile (1024x768 pixel) map in ROM bank 1, made of blocks of
+   8x8 tiles with a grid line along their top and left edges, in four
+   shades laid out diagonally.
+ */
+#include <gb/gb.h>
+
+/* Tiles 0, 2, 4, 6 are plain shades, 1, 3, 5, 7 the same with the grid */
+#define SHADE(b)        (((b) & 3) * 2)
+
+#define TOP(b)          SHADE(b) + 1, SHADE(b) + 1, SHADE(b) + 1, SHADE(b) + 1, \
+                        SHADE(b) + 1, SHADE(b) + 1, SHADE(b) + 1, SHADE(b) + 1
+#define INSIDE(b)       SHADE(b) + 1, SHADE(b), SHADE(b), SHADE(b), \
+                        SHADE(b), SHADE(b), SHADE(b), SHADE(b)
+
+#define ROW(E, p)       E(p), E(p + 1), E(p + 2), E(p + 3), E(p + 4), E(p + 5), E(p + 6), E(p + 7), \
+                        E(p + 8), E(p + 9), E(p + 10), E(p + 11), E(p + 12), E(p + 13), E(p + 14), E(p + 15)
+
+#define BLOCKS(p)       ROW(TOP, p), ROW(INSIDE, p), ROW(INSIDE, p), ROW(INSIDE, p), \
+                        ROW(INSIDE, p), ROW(INSIDE, p), ROW(INSIDE, p), ROW(INSIDE, p)
+
+const UINT8 world_map[] = {
+  BLOCKS(0), BLOCKS(1), BLOCKS(2), BLOCKS(3),
+  BLOCKS(4), BLOCKS(5), BLOCKS(6), BLOCKS(7),
+  BLOCKS(8), BLOCKS(9), BLOCKS(10), BLOCKS(11)
+};
@@ -62,6 +62,116 @@ set_sprite_palette_entry(UINT8 palette,
                          UINT8 entry,
                          UINT16 rgb_data);
 
+/** Copies __len__ bytes from __src__ to VRAM at __dst__, with DMA on CGB.
+
+    @param dst   Destination in VRAM
+    @param src   Source data
+    @param len   Number of bytes to copy
+    @param bank  ROM bank of __src__, or 0 for the current bank
+
+    On CGB the copy uses general DMA while the LCD is off or in VBlank,
+    which is more than ten times faster than copying with the CPU, and
+    HBlank DMA (16 bytes per line) while the screen is drawn. DMA needs
+    __src__, __dst__ and __len__ to be multiples of 16, and __src__
+    outside VRAM. Otherwise, and on DMG, the data is copied by the CPU.
+
+    The source bank is switched in for the copy, and the current bank
+    restored afterwards.
+*/
+void hdma_copy(void *dst, const void *src, UINT16 len, UINT8 bank) NONBANKED;
+
+/** Version of @ref set_bkg_data using @ref hdma_copy, for data in ROM bank __bank__
+ */
+void set_bkg_data_dma(UINT8 first_tile, UINT8 nb_tiles, unsigned char *data, UINT8 bank) NONBANKED;
+
+/** Version of @ref set_sprite_data using @ref hdma_copy, for data in ROM bank __bank__
+ */
+void set_sprite_data_dma(UINT8 first_tile, UINT8 nb_tiles, unsigned char *data, UINT8 bank) NONBANKED;
+
+/** Version of @ref set_bkg_tiles using @ref hdma_copy, for tiles in ROM bank __bank__
+
+    DMA is only used for rows which start and end on a multiple of 16
+    tiles, such as full width (32 tile) rows, with __tiles__ aligned
+    to 16 bytes.
+ */
+void set_bkg_tiles_dma(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles, UINT8 bank) NONBANKED;
+
+/** Version of @ref set_win_tiles using @ref hdma_copy, for tiles in ROM bank __bank__
+
+    @see set_bkg_tiles_dma
+ */
+void set_win_tiles_dma(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles, UINT8 bank) NONBANKED;
+
+/** Sets a rectangle of CGB tile attributes in the background map
+
+    @param x      X Start position in Map tile coordinates. Range 0 - 31
+    @param y      Y Start position in Map tile coordinates. Range 0 - 31
+    @param w      Width of area to set in tiles. Range 1 - 32
+    @param h      Height of area to set in tiles. Range 1 - 32
+    @param attrs  Attributes, one byte per tile, row after row
+
+    Like @ref set_bkg_tiles with @ref VBK_REG set to 1, which is set back
+    to 0 afterwards. Updates the mirror set by @ref set_bkg_attributes_mirror.
+ */
+void set_bkg_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *attrs) NONBANKED;
+
+/** Sets a rectangle of CGB tile attributes in the window map
+
+    @see set_bkg_attributes
+ */
+void set_win_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *attrs) NONBANKED;
+
+/** Gets a rectangle of CGB tile attributes from the background map
+
+    Reads the mirror set by @ref set_bkg_attributes_mirror if there is
+    one, otherwise VRAM bank 1, waiting for STAT like @ref get_bkg_tiles.
+
+    @see set_bkg_attributes
+ */
+void get_bkg_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *attrs) NONBANKED;
+
+/** Gets a rectangle of CGB tile attributes from the window map
+
+    @see get_bkg_attributes
+ */
+void get_win_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *attrs) NONBANKED;
+
+/** Sets a rectangle of tiles and their CGB attributes in the background map
+
+    @param tiles  Tiles, one byte per tile, row after row
+    @param attrs  Attributes, one byte per tile, row after row
+
+    Writes each tile and its attribute after the same STAT wait, which
+    with the display on takes about half the time of @ref set_bkg_tiles
+    followed by @ref set_bkg_attributes.
+
+    @see set_bkg_attributes
+ */
+void set_bkg_tiles_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles, unsigned char *attrs) NONBANKED;
+
+/** Sets a rectangle of tiles and their CGB attributes in the window map
+
+    @see set_bkg_tiles_attributes
+ */
+void set_win_tiles_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles, unsigned char *attrs) NONBANKED;
+
+/** Keeps a copy of the background map attributes in WRAM
+
+    @param mirror  32 x 32 byte buffer, or NULL to stop
+
+    Attributes written by @ref set_bkg_attributes and
+    @ref set_bkg_tiles_attributes are also written to __mirror__, and
+    @ref get_bkg_attributes reads them back from it instead of VRAM.
+    Attributes already in VRAM are not copied to it.
+ */
+void set_bkg_attributes_mirror(UINT8 *mirror) NONBANKED;
+
+/** Keeps a copy of the window map attributes in WRAM
+
+    @see set_bkg_attributes_mirror
+ */
+void set_win_attributes_mirror(UINT8 *mirror) NONBANKED;
+
 /** Set CPU speed to slow operation.
     Make sure interrupts are disabled before call.
 
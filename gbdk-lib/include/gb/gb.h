@@ -262,6 +262,49 @@ void nowait_int_handler(void) NONBANKED;
 void wait_int_handler(void) NONBANKED;
 
 
+/** Addresses of the interrupt vectors, for @ref ISR_VECTOR
+*/
+#define VECTOR_VBL   0x40
+#define VECTOR_LCD   0x48
+#define VECTOR_TIM   0x50
+#define VECTOR_SIO   0x58
+#define VECTOR_JOY   0x60
+
+/** Interrupt vector made by @ref ISR_VECTOR: a JP to the handler
+*/
+typedef struct isr_vector_t {
+    UINT8 opcode;             //< 0xC3, JP nn
+    void (*handler)(void);    //< Address jumped to
+} isr_vector_t;
+
+/** Makes interrupt vector __V__ jump straight to __HANDLER__
+
+    @param V        One of VBL, LCD, TIM, SIO or JOY
+    @param HANDLER  Function declared with __interrupt, which saves
+                    the registers and returns with RETI
+
+    Goes at file scope in one source file of the program. The handler
+    is called without going through the chain of handlers added with
+    @ref add_VBL and the like, which takes about 17 M-cycles more per
+    interrupt, plus the wait for STAT before returning.
+
+    Using add_xxx() as well for the same LCD, TIM, SIO or JOY vector
+    is a link error. Handlers added with @ref add_VBL aren't called,
+    including the default one, so a VBL handler must do its work:
+    @ref wait_vbl_done doesn't return, @ref sys_time isn't counted and
+    @ref shadow_OAM isn't copied to OAM.
+
+    \code{.c}
+    void timer_isr(void) __interrupt {
+        ticks++;
+    }
+    ISR_VECTOR(TIM, timer_isr);
+    \endcode
+*/
+#define ISR_VECTOR(V, HANDLER) \
+    const isr_vector_t __at(VECTOR_ ## V) __isr_vector_ ## V = { 0xC3, HANDLER }
+
+
 
 /** Set the current screen mode - one of M_* modes
 
@@ -975,9 +1018,27 @@ typedef struct OAM_item_t {
 
 
 /** Shadow OAM array in WRAM, that is DMA-transferred into the real OAM each VBlank
+
+    Once @ref commit_sprites has been called, it is only shown when committed.
 */
 extern volatile struct OAM_item_t shadow_OAM[];
 
+/** Shows the sprites as they are now in @ref shadow_OAM from the next VBlank
+
+    Copies @ref shadow_OAM to a second page, which the VBlank handler
+    DMAs into OAM once per commit, instead of DMAing
+    @ref shadow_OAM every VBlank. Sprites changed after a commit aren't
+    shown until the next one, so they never tear half way through being
+    moved, and scenes which don't change don't spend any time on the DMA.
+
+    The first call switches to committing for the rest of the program.
+    Takes about 1000 M-cycles. The second page needs a 415 byte buffer
+    in RAM to be sure of holding a page aligned copy, which only
+    programs calling commit_sprites() have. Not for use with @ref sprite_mux_split,
+    which DMAs @ref shadow_OAM itself.
+*/
+void commit_sprites(void) NONBANKED;
+
 
 /** Sets sprite number __nb__ to display tile number __tile__.
 
@@ -0,0 +1,81 @@
+/** @file gb/metasprites.h
+    Metasprites, groups of hardware sprites moved together.
+
+    A metasprite is an array of @ref metasprite_t entries, one per
+    hardware sprite, with offsets from the origin of the metasprite,
+    ended by @ref METASPR_TERM. For example a 16x16 metasprite of 8x8
+    sprites, with the origin in the middle:
+
+    \code
+    const metasprite_t player[] = {
+        METASPR_ITEM(-8, -8, 0, 0), METASPR_ITEM(-8, 0, 1, 0),
+        METASPR_ITEM( 0, -8, 2, 0), METASPR_ITEM( 0, 0, 3, 0),
+        METASPR_TERM
+    };
+    \endcode
+
+    The move functions write the entries straight into @ref shadow_OAM,
+    starting at hardware sprite __base_sprite__, and return how many
+    hardware sprites they used. Sprites after those are left alone.
+*/
+#ifndef _METASPRITES_H
+#define _METASPRITES_H
+
+#include <gb/gb.h>
+
+/** Entry of a metasprite, one hardware sprite
+
+    @param dy     Y offset from the origin of the metasprite
+    @param dx     X offset from the origin of the metasprite
+    @param dtile  Tile, added to the base tile
+    @param props  OAM Property Flags (see @ref set_sprite_prop)
+*/
+typedef struct metasprite_t {
+    INT8  dy, dx;
+    UINT8 dtile;
+    UINT8 props;
+} metasprite_t;
+
+/** Value of dy which ends a metasprite */
+#define metasprite_end -128
+#define METASPR_ITEM(dy,dx,dt,a) {(dy),(dx),(dt),(a)}
+#define METASPR_TERM {metasprite_end}
+
+/** Moves metasprite __metasprite__ to __x__, __y__
+
+    @param metasprite   Entries of the metasprite, ended by @ref METASPR_TERM
+    @param base_tile    Added to the tile of each entry
+    @param base_sprite  First hardware sprite to use, range 0 - 39
+    @param x            X position of the origin, as for @ref move_sprite
+    @param y            Y position of the origin, as for @ref move_sprite
+
+    Returns the number of hardware sprites used. The metasprite must
+    fit in the 40 hardware sprites from __base_sprite__.
+*/
+UINT8 move_metasprite(const metasprite_t *metasprite, UINT8 base_tile, UINT8 base_sprite, UINT8 x, UINT8 y) NONBANKED;
+
+/** Moves metasprite __metasprite__ to __x__, __y__, flipped horizontally
+
+    Each entry is mirrored around the origin, to x - dx - 8, with
+    @ref S_FLIPX toggled.
+
+    @see move_metasprite
+*/
+UINT8 move_metasprite_hflip(const metasprite_t *metasprite, UINT8 base_tile, UINT8 base_sprite, UINT8 x, UINT8 y) NONBANKED;
+
+/** Moves metasprite __metasprite__ to __x__, __y__, flipped vertically
+
+    Each entry is mirrored around the origin, to y - dy - 8 (or - 16
+    with @ref SPRITES_8x16), with @ref S_FLIPY toggled.
+
+    @see move_metasprite
+*/
+UINT8 move_metasprite_vflip(const metasprite_t *metasprite, UINT8 base_tile, UINT8 base_sprite, UINT8 x, UINT8 y) NONBANKED;
+
+/** Moves metasprite __metasprite__ to __x__, __y__, flipped both ways
+
+    @see move_metasprite_hflip, move_metasprite_vflip
+*/
+UINT8 move_metasprite_hvflip(const metasprite_t *metasprite, UINT8 base_tile, UINT8 base_sprite, UINT8 x, UINT8 y) NONBANKED;
+
+#endif /* _METASPRITES_H */
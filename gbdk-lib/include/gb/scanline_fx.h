@@ -0,0 +1,64 @@
+/** @file gb/scanline_fx.h
+    Per line scroll, window and palette effects from a table.
+
+    The table is a list of runs, each giving values for
+    @ref SCX_REG, @ref SCY_REG, @ref WX_REG and @ref BGP_REG and how
+    many lines they are kept for, from the top of the screen down.
+    The VBL handler sets up the first run. The LY = LYC interrupt on
+    the last line of each run writes the next one in that line's
+    HBlank, straight from the LCD interrupt vector, so a table costs
+    time for each change rather than for each line.
+
+    A new table passed to @ref scanline_fx_show is only picked up at
+    the next VBlank, so the next frame's table can be built in the
+    main loop while the current one is shown: keep two tables, and
+    after @ref wait_vbl_done fill in the one not being shown.
+
+    Each change takes 131 to 163 M-cycles, depending on how long the
+    line takes to draw, out of the 17556 in a frame. A run of one line
+    keeps the CPU for the whole of that line, so a table that changes
+    on every line leaves only the VBlank period for the game.
+
+    The effects own the LCD interrupt vector: they can't be used
+    together with @ref add_LCD or ISR_VECTOR(LCD, ...).
+*/
+#ifndef _SCANLINE_FX_H
+#define _SCANLINE_FX_H
+
+#include <gb/gb.h>
+
+/** Register values for a run of lines
+*/
+typedef struct scanline_run_t {
+    UINT8 scx, scy;  //< Background scroll
+    UINT8 wx;        //< Window X position
+    UINT8 bgp;       //< Background palette
+    UINT8 lines;     //< Number of lines, 0 for the rest of the screen
+} scanline_run_t;
+
+/** Starts the effects, with __table__ shown from the next VBlank
+
+    @param table  Runs covering the 144 lines of the screen
+
+    Must be called with interrupts disabled. The LCD interrupt is
+    enabled, and LYC is used by the effects until @ref scanline_fx_stop.
+*/
+void scanline_fx_start(const scanline_run_t *table) NONBANKED;
+
+/** Shows __table__ from the next VBlank
+
+    @param table  Runs covering the 144 lines of the screen
+
+    __table__ is read on every frame from then on, so must not change
+    until another table has been picked up.
+*/
+void scanline_fx_show(const scanline_run_t *table) NONBANKED;
+
+/** Stops the effects and disables the LCD interrupt
+
+    Must be called with interrupts disabled. The registers keep the
+    values they had.
+*/
+void scanline_fx_stop(void) NONBANKED;
+
+#endif /* _SCANLINE_FX_H */
@@ -0,0 +1,49 @@
+/** @file gb/scroll_map.h
+    Scrolling over tile maps larger than the 32x32 background map.
+
+    The background map is used as a ring: tile (x, y) of the map goes
+    to (x % 32, y % 32) of the background, with the same wraparound
+    as @ref set_bkg_tiles, and SCX and SCY are set to the camera
+    position % 256. Each move of the camera only uploads the columns
+    and rows of tiles which have just come into view.
+
+    Moving up to 8 pixels each way uploads at most one column (19 tiles)
+    and one row (21 tiles), which takes about 2200 M-cycles (19 lines).
+    Called right after @ref wait_vbl_done, half of that is done in VBlank
+    and the rest waits for STAT like @ref set_bkg_tiles.
+
+    Only one map is scrolled at a time.
+*/
+#ifndef _SCROLL_MAP_H
+#define _SCROLL_MAP_H
+
+#include <gb/gb.h>
+
+/** Sets up the map to scroll over, and shows it from __x__, __y__
+
+    @param tiles   Map, one tile index per byte, row after row
+    @param width   Width of the map in tiles
+    @param height  Height of the map in tiles
+    @param bank    ROM bank of __tiles__, or 0 for the current bank
+    @param x       Camera position in pixels, from 0 to width * 8 - 160
+    @param y       Camera position in pixels, from 0 to height * 8 - 144
+
+    Uploads the whole screen, so is best done with the display off.
+    The source bank is switched in for the upload, and the current bank
+    restored afterwards, here and in @ref scroll_map_move.
+*/
+void scroll_map_set(const UINT8 *tiles, UINT16 width, UINT16 height, UINT8 bank, UINT16 x, UINT16 y) NONBANKED;
+
+/** Moves the camera to __x__, __y__
+
+    @param x  Camera position in pixels, from 0 to width * 8 - 160
+    @param y  Camera position in pixels, from 0 to height * 8 - 144
+
+    Uploads the tiles which have come into view and sets SCX and SCY.
+    Larger moves are allowed, uploading up to the whole screen.
+
+    @see scroll_map_set
+*/
+void scroll_map_move(UINT16 x, UINT16 y) NONBANKED;
+
+#endif /* _SCROLL_MAP_H */
@@ -0,0 +1,77 @@
+/** @file gb/shadow_map.h
+    WRAM shadows of the background and window maps, uploaded by row.
+
+    A shadow is a 32 x 32 byte buffer in WRAM holding the whole map,
+    tile (x, y) at shadow[y * 32 + x]. Game code reads it directly
+    instead of using @ref get_bkg_tiles, and changes it with
+    @ref set_bkg_shadow_tiles or by writing it directly followed by
+    @ref mark_bkg_shadow. Each row keeps a dirty bit and the first and
+    last dirty column, and @ref flush_bkg_shadow uploads just those, so
+    a frame which changes a few cells costs a few short rows instead of
+    a full screen.
+*/
+#ifndef _SHADOW_MAP_H
+#define _SHADOW_MAP_H
+
+#include <gb/gb.h>
+
+/** Sets the shadow of the background map
+
+    @param shadow  32 x 32 byte buffer
+
+    Nothing is marked dirty. The buffer is not read from VRAM, so fill
+    it and mark it all (or upload it with @ref set_bkg_tiles) to start
+    from a known map.
+*/
+void set_bkg_shadow(UINT8 *shadow) NONBANKED;
+
+/** Sets the shadow of the window map
+
+    @see set_bkg_shadow
+*/
+void set_win_shadow(UINT8 *shadow) NONBANKED;
+
+/** Version of @ref set_bkg_tiles which writes to the shadow
+
+    Only tiles which differ from the shadow are marked dirty, so
+    rewriting a whole screen which has hardly changed uploads little.
+*/
+void set_bkg_shadow_tiles(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles) NONBANKED;
+
+/** Version of @ref set_win_tiles which writes to the shadow
+
+    @see set_bkg_shadow_tiles
+*/
+void set_win_shadow_tiles(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles) NONBANKED;
+
+/** Marks a rectangle of the background shadow as dirty
+
+    @param x  X Start position in Map tile coordinates. Range 0 - 31
+    @param y  Y Start position in Map tile coordinates. Range 0 - 31
+    @param w  Width of area in tiles. Range 0 - 32
+    @param h  Height of area in tiles. Range 0 - 32
+
+    For after writing the shadow directly.
+*/
+void mark_bkg_shadow(UINT8 x, UINT8 y, UINT8 w, UINT8 h) NONBANKED;
+
+/** Marks a rectangle of the window shadow as dirty
+
+    @see mark_bkg_shadow
+*/
+void mark_win_shadow(UINT8 x, UINT8 y, UINT8 w, UINT8 h) NONBANKED;
+
+/** Uploads the dirty part of each dirty row of the background shadow
+
+    Each row is copied with @ref set_bkg_tiles, waiting for STAT, so
+    it is best called right after @ref wait_vbl_done.
+*/
+void flush_bkg_shadow(void) NONBANKED;
+
+/** Uploads the dirty part of each dirty row of the window shadow
+
+    @see flush_bkg_shadow
+*/
+void flush_win_shadow(void) NONBANKED;
+
+#endif /* _SHADOW_MAP_H */
@@ -0,0 +1,63 @@
+/** @file gb/sprite_mux.h
+    Sprite multiplexing, more logical sprites than the hardware shows.
+
+    The logical sprites are a table of @ref OAM_item_t entries in RAM,
+    moved by the program like @ref shadow_OAM. Each update copies the
+    ones on screen into the hardware sprites from __first_slot__ on,
+    starting from a different logical sprite each frame. The start moves
+    on by about half the table each time, by a step sharing no factor
+    with __count__, so each logical sprite comes first in turn. Sprites
+    over the 40 sprite limit, and over the 10 sprites per line the
+    hardware draws, so take turns and flicker instead of disappearing.
+    Sprites with Y = 0 or Y >= 160 are skipped.
+
+    With a split line set, the sprites above and below it are kept in two
+    bands which can each use all the hardware sprites, and the LCD
+    interrupt copies the bottom band to OAM just before the split. That
+    also helps with the 10 sprites per line limit when the crowd is
+    spread over the screen. The bands are kept twice, about 640 bytes,
+    so an update can fill one pair while the interrupts copy the other.
+
+    An update of 30 sprites takes about 1600 M-cycles, 60 sprites about
+    2300, and 70 sprites in two bands about 5300.
+*/
+#ifndef _SPRITE_MUX_H
+#define _SPRITE_MUX_H
+
+#include <gb/gb.h>
+
+/** Sets the table of logical sprites
+
+    @param sprites     Logical sprites, Y and X as for @ref move_sprite
+    @param count       Number of logical sprites, range 1 - 255
+    @param first_slot  First hardware sprite to use, range 0 - 39
+
+    Hardware sprites before __first_slot__ are left alone, so can be
+    used with @ref move_sprite or @ref move_metasprite as usual.
+*/
+void sprite_mux_init(OAM_item_t *sprites, UINT8 count, UINT8 first_slot) NONBANKED;
+
+/** Copies the logical sprites into the hardware sprites
+
+    Best called right after @ref wait_vbl_done, once all the logical
+    sprites have been moved for the frame.
+
+    Returns the number of sprites on screen which didn't fit this frame.
+*/
+UINT8 sprite_mux_update(void) NONBANKED;
+
+/** Splits the sprites into two bands at line __line__
+
+    @param line  Screen line of the split, range 8 - 143, or 0 for
+                 one band
+
+    Uses LYC and adds a VBL and an LCD interrupt handler, so must be
+    called with interrupts disabled as for @ref add_LCD. A __line__ of
+    0 removes them again and turns the LYC interrupt off. The bottom
+    band is DMAed to OAM 2 lines before the split, and no sprites are
+    drawn while that runs. Each interrupt also copies a band to
+    @ref shadow_OAM, about 1000 M-cycles each with all 40 sprites.
+*/
+void sprite_mux_split(UINT8 line) NONBANKED;
+
+#endif /* _SPRITE_MUX_H */
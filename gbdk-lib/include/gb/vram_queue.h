@@ -0,0 +1,78 @@
+/** @file gb/vram_queue.h
+    Queued VRAM transfers, copied during VBlank by the VBL interrupt.
+
+    The set_*_queued functions return as soon as the copy is queued
+    instead of waiting for STAT before every few bytes like
+    @ref set_bkg_data and @ref set_bkg_tiles. The default VBL handler
+    then copies queued data in 16 byte chunks, up to a per frame
+    budget (see @ref set_vram_queue_budget), so large updates spill
+    over several frames instead of stalling the main loop.
+
+    The source data must stay unchanged until it has been copied
+    (see @ref vram_queue_wait). Source data in switchable ROM is
+    copied from the bank which was active when it was queued. On the
+    CGB it always goes to VRAM bank 0, even if the VBlank comes while
+    bank 1 is selected, as in @ref set_bkg_attributes.
+
+    When the display is off everything is copied right away.
+*/
+#ifndef _VRAM_QUEUE_H
+#define _VRAM_QUEUE_H
+
+#include <gb/gb.h>
+
+/** Queues a copy of __len__ bytes from __src__ to VRAM at __dst__
+
+    @param dst   Destination in VRAM
+    @param src   Source data, in RAM, bank 0 or the current ROM bank
+    @param len   Number of bytes to copy
+
+    Returns 0 if the queue is full (32 jobs), non-zero otherwise.
+
+    @see vram_queue_wait
+*/
+UINT8 vram_queue(void *dst, const void *src, UINT16 len) NONBANKED;
+
+/** Waits until everything queued has been copied to VRAM
+*/
+void vram_queue_wait(void) NONBANKED;
+
+/** Returns the number of queued copies which are not finished yet
+*/
+UINT8 vram_queue_pending(void) NONBANKED;
+
+/** Sets the most bytes copied to VRAM in each VBlank
+
+    @param bytes  Bytes per frame, rounded up to a multiple of 16 (16 - 4080)
+
+    The default is 160 bytes, which leaves room in VBlank for other VBL handlers.
+    Copying also stops when VBlank is over, whatever the budget.
+*/
+void set_vram_queue_budget(UINT16 bytes) NONBANKED;
+
+/** Queued version of @ref set_bkg_data
+
+    Waits for room in the queue if it is full.
+*/
+void set_bkg_data_queued(UINT8 first_tile, UINT8 nb_tiles, unsigned char *data) NONBANKED;
+
+/** Queued version of @ref set_sprite_data
+
+    Waits for room in the queue if it is full.
+*/
+void set_sprite_data_queued(UINT8 first_tile, UINT8 nb_tiles, unsigned char *data) NONBANKED;
+
+/** Queued version of @ref set_bkg_tiles
+
+    One copy is queued per row (two if the row wraps around the
+    right edge of the map). Waits for room in the queue if it is full.
+*/
+void set_bkg_tiles_queued(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles) NONBANKED;
+
+/** Queued version of @ref set_win_tiles
+
+    @see set_bkg_tiles_queued
+*/
+void set_win_tiles_queued(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles) NONBANKED;
+
+#endif /* _VRAM_QUEUE_H */
@@ -0,0 +1,74 @@
+/** @file gb/vram_unpack.h
+    Decompression of packed tile and map data straight into VRAM.
+
+    The data is packed on the host with gbpack (gbdk-support/gbpack),
+    as runs of literal bytes, runs of one byte and short matches of
+    earlier output (LZ77). Decoding writes to VRAM as it goes, waiting
+    for STAT while the display is on, so no WRAM buffer is needed.
+
+    As with @ref set_bkg_data, data written past 0x97FF carries on at
+    0x8800, so tiles 128-255 of the 0x9000 tile block follow tiles 0-127.
+
+    Large sets can be decoded a part at a time over several frames with
+    @ref vram_unpack_init and @ref vram_unpack_step.
+*/
+#ifndef _VRAM_UNPACK_H
+#define _VRAM_UNPACK_H
+
+#include <gb/gb.h>
+
+/** Progress of a decoding done in parts
+
+    @see vram_unpack_init, vram_unpack_step
+*/
+typedef struct vram_unpack_t {
+  UINT8 *dst;             /**< Next byte of VRAM to write */
+  const UINT8 *src;       /**< Next byte of packed data */
+  UINT8 wrapped;          /**< Output went past 0x97FF to 0x8800 */
+} vram_unpack_t;
+
+/** Decodes packed data from __src__ to VRAM at __dst__
+
+    @param dst   Destination in VRAM
+    @param src   Data packed by gbpack
+*/
+void vram_unpack(void *dst, const void *src) NONBANKED;
+
+/** Decodes packed tile data to the background tiles, starting at __first_tile__
+
+    @param first_tile  Index of the first tile to write
+    @param data        Tile data packed by gbpack
+
+    Uses the same tile block as @ref set_bkg_data, following LCDC bit 3.
+*/
+void set_bkg_data_unpack(UINT8 first_tile, const void *data) NONBANKED;
+
+/** Decodes packed tile data to the sprite tiles, starting at __first_tile__
+
+    @param first_tile  Index of the first tile to write
+    @param data        Tile data packed by gbpack
+*/
+void set_sprite_data_unpack(UINT8 first_tile, const void *data) NONBANKED;
+
+/** Sets up __s__ to decode packed data from __src__ to VRAM at __dst__ in parts
+
+    @param s     State of the decoding
+    @param dst   Destination in VRAM, for tiles 0x8000 or 0x9000 + 16 * first tile
+    @param src   Data packed by gbpack
+
+    @see vram_unpack_step
+*/
+void vram_unpack_init(vram_unpack_t *s, void *dst, const void *src) NONBANKED;
+
+/** Decodes about __bytes__ more bytes of the data set up with @ref vram_unpack_init
+
+    @param s      State of the decoding
+    @param bytes  Bytes to decode. Decoding stops at the end of the token
+                  which reaches this, so up to 126 more may be written.
+
+    Returns 1 once all the data has been decoded, 0 otherwise.
+    The packed data must stay mapped in between calls.
+*/
+UINT8 vram_unpack_step(vram_unpack_t *s, UINT16 bytes) NONBANKED;
+
+#endif /* _VRAM_UNPACK_H */
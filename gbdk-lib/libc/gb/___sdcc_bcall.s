@@ -2,22 +2,28 @@
 
 	.area _BASE
 
+	;; When the target is in the current bank, the bank switches are
+	;; skipped and the call returns through banked_ret_same, which only
+	;; drops the saved bank. The stack is laid out the same either way.
+
 ___sdcc_bcall::
 banked_call::			; Performs a long call.
 	pop	hl		; Get the return address
-	ldh	a,(__current_bank)
-	push	af		; Push the current bank onto the stack
 	ld	a,(hl+)		; Fetch the call address
 	ld	e, a
 	ld	a,(hl+)
 	ld	d, a
+	ldh	a,(__current_bank)
+	push	af		; Push the current bank onto the stack
+	cp	(hl)		; Same page?
 	ld	a,(hl+)		; ...and page
 	inc	hl		; Yes this should be here
 	push	hl		; Push the real return address
-	ldh	(__current_bank),a
-	ld	(.MBC1_ROM_PAGE),a	; Perform the switch
 	ld	l,e
 	ld	h,d
+	jr	z,banked_call_same
+	ldh	(__current_bank),a
+	ld	(.MBC1_ROM_PAGE),a	; Perform the switch
 	rst	0x20
 banked_ret::
 	pop	hl		; Get the return address
@@ -25,3 +31,10 @@ banked_ret::
 	ldh	(__current_bank),a
 	ld	(.MBC1_ROM_PAGE),a
 	jp	(hl)
+
+banked_call_same:
+	rst	0x20
+banked_ret_same:
+	pop	hl		; Get the return address
+	pop	af		; Drop the old bank, it is still current
+	jp	(hl)
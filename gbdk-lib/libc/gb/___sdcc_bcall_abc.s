@@ -0,0 +1,37 @@
+	.include	"global.s"
+
+	.area _BASE
+
+	;; Banked call for asm routines taking their arguments in
+	;; registers: A = bank, BC = address. DE and HL reach the routine
+	;; untouched, and A, DE and HL from the routine come back untouched.
+	;; BC and the flags are not kept.
+	;;
+	;; When the routine is in the current bank this is just a jump to
+	;; it, so it returns straight to the caller. Otherwise the old bank
+	;; is kept on the stack under the return into here, so the routine
+	;; can't take arguments on the stack.
+
+___sdcc_bcall_abc::		; Performs a long call.
+	push	bc		; Address to jump to with RET
+	ld	b,a		; B = bank of the routine
+	ldh	a,(__current_bank)
+	cp	b
+	ret	z		; Same page, just jump there
+	ld	c,a		; C = old bank
+	ld	a,b
+	ldh	(__current_bank),a
+	ld	(.MBC1_ROM_PAGE),a	; Perform the switch
+	ld	a,c
+	pop	bc		; BC = address again
+	push	af		; Push the old bank onto the stack
+	call	1$
+	ld	b,a		; Keep A from the routine
+	pop	af		; Pop the old bank
+	ldh	(__current_bank),a
+	ld	(.MBC1_ROM_PAGE),a
+	ld	a,b
+	ret
+1$:
+	push	bc		; Jump to BC
+	ret
@@ -3,8 +3,10 @@
 	.area _BASE
 
 ___sdcc_bcall_ehl::			; Performs a long call.
-ldh a,(__current_bank)
+	ldh	a,(__current_bank)
 	push	af			; Push the current bank onto the stack
+	cp	e			; Same page, no switch
+	jr	z,1$
 	ld	a, e
 	ldh	(__current_bank),a
 	ld	(.MBC1_ROM_PAGE),a	; Perform the switch
@@ -12,4 +14,8 @@ ldh a,(__current_bank)
 	pop	af			; Pop the old bank
 	ldh	(__current_bank),a
 	ld	(.MBC1_ROM_PAGE),a
-	ret
\ No newline at end of file
+	ret
+1$:
+	rst	0x20
+	pop	af			; Drop the old bank, it is still current
+	ret
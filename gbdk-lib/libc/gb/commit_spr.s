@@ -0,0 +1,44 @@
+	.include	"global.s"
+
+	;; The committed sprites go in a second page, which only VBL reads,
+	;; so are never DMAed half written. VBL then DMAs that page once per
+	;; commit instead of _shadow_OAM every frame.
+	;;
+	;; The linker can't align an area to a page, so the page is the
+	;; first one starting in .commit_buf, at the high byte of
+	;; .commit_buf + 0xFF, and the buffer is long enough to hold its 40
+	;; entries wherever it lands. Only programs which use
+	;; commit_sprites() have the buffer.
+
+	;; BANKED:	checked
+	.area	_BASE
+
+	;; void commit_sprites(void)
+_commit_sprites::		; Non-banked
+	PUSH	BC
+	XOR	A		; No DMA while the page is copied
+	LDH	(.oam_dma),A
+	LD	HL,#_shadow_OAM
+	LD	D,#>(.commit_buf + 0xFF)
+	LD	E,#0
+	LD	C,#40		; 40 entries 4 bytes each, in one page
+1$:
+	.rept	4
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	E
+	.endm
+	DEC	C
+	JR	NZ,1$
+
+	LD	A,#>(.commit_buf + 0xFF)	; DMA from this page from now on
+	LD	(.refresh_OAM+1),A
+	LD	A,#.OAM_DMA_COMMIT
+	LDH	(.oam_dma),A
+	POP	BC
+	RET
+
+	.area	_BSS
+
+.commit_buf:
+	.ds	0xFF + 0xA0	; Holds a page aligned 40 entries
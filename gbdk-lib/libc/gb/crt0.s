@@ -39,12 +39,8 @@
 ;	.org	0x38		; crash handler utilized by crash_handler.h
 
 	;; Hardware interrupt vectors
-	.org	0x40		; VBL
-.int_VBL:
-	PUSH	AF
-	PUSH	HL
-	LD	HL,#.int_0x40
-	JP	.int
+;	.org	0x40		; VBL, in int_vbl.s unless the program has
+	.globl	___isr_vector_VBL	; its own (see ISR_VECTOR)
 
 ;	.org	0x48		; LCD
 
@@ -94,8 +90,13 @@ _wait_int_handler::
 	INC	HL
 	INC	(HL)
 2$:
+	LDH	A,(.oam_dma)	; DMA every VBlank, or once after commit_sprites()
+	OR	A
+	JR	Z,3$
+	AND	#.OAM_DMA_ALWAYS	; Commit done
+	LDH	(.oam_dma),A
 	CALL	.refresh_OAM
-
+3$:
 	LD	A,#0x01
 	LDH	(.vbl_done),A
 	RET
@@ -201,6 +202,8 @@ _reset::
 
 	;; Clear the OAM by calling refresh_OAM
 	CALL	.refresh_OAM
+	LD	A,#.OAM_DMA_ALWAYS
+	LDH	(.oam_dma),A
 
 	;; Install interrupt routines
 	LD	BC,#.std_vbl
@@ -337,6 +340,8 @@ __current_bank::	; Current bank
 	.ds	0x01
 .vbl_done:
 	.ds	0x01		; Is VBL interrupt finished?
+.oam_dma::
+	.ds	0x01		; When VBL DMAs the shadow OAM (.OAM_DMA_xxx)
 
 	;; Runtime library
 	.area	_GSINIT
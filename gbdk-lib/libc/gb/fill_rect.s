@@ -36,12 +36,17 @@
 	LD	C,A		; dest BC = HL + 0x20 * Y + X
 
 	POP	HL		; H = Tile
+	LDH	A,(.LCDC)	; L bit 0 = LCD is on
+	LD	L, A
 	POP	DE		; DE = WH
 	PUSH	DE		; store WH
 	PUSH	BC		; store dest
 
 3$:				; Copy W tiles
+	BIT	0, L
+	JR	Z, 5$		; LCD is off, no need to wait for STAT
 
+4$:
 	WAIT_STAT
 	LD	A, H
 	LD	(BC), A
@@ -56,8 +61,24 @@
 	LD	C, A
 
 	DEC	D
-	JR	NZ, 3$
+	JR	NZ, 4$
+	JR	6$
 
+5$:
+	LD	A, H
+	LD	(BC), A
+
+	LD	A, C		; inc dest and wrap around
+	INC	A
+	XOR	C
+	AND	#0x1F
+	XOR	C
+	LD	C, A
+
+	DEC	D
+	JR	NZ, 5$
+
+6$:
 	POP	BC
 	POP	DE
 
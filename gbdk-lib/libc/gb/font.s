@@ -79,6 +79,13 @@ font_copy_uncompressed::
 	sub	#0x98-0x88
 	ld	h,a
 4$:
+	ldh	a,(.LCDC)
+	rra
+	jr	c,5$		; LCD is on
+	ld	a,l
+	and	#0x0F
+	jr	z,6$		; LCD is off and whole tiles, no need to wait for STAT
+5$:
 	xor	a
 	cp	e		; Special for when e=0 you will get another loop
 	jr	nz,1$
@@ -108,6 +115,44 @@ font_copy_uncompressed::
 	jr	z,1$
 	ret
 
+6$:				; DE / 8 tiles, then DE % 8 words
+	ld	a,e
+	and	#0x07
+	push	af
+	srl	d
+	rr	e
+	srl	d
+	rr	e
+	srl	d
+	rr	e
+	ld	a,d
+	or	e
+	jr	z,9$
+	inc	d
+	inc	e
+	jr	8$
+7$:
+	.rept	16
+	ld	a,(bc)
+	ld	(hl+),a
+	inc	bc
+	.endm
+	ld	a,h		; Special wrap-around
+	cp	#0x98
+	jr	nz,8$
+	ld	h,#0x88
+8$:
+	dec	e
+	jr	nz,7$
+	dec	d
+	jr	nz,7$
+9$:
+	pop	af
+	ret	z
+	ld	e,a		; The last few words
+	ld	d,#0
+	jp	5$
+
 	; Copy a set of compressed (8 bytes/cell) tiles to VRAM
 	; Sets the foreground and background colours based on the current
 	; font colours
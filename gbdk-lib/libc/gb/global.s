@@ -29,6 +29,9 @@
 	.TIM_IFLAG	= 0x04
 	.SIO_IFLAG	= 0x08
 	.JOY_IFLAG	= 0x10
+
+	.OAM_DMA_ALWAYS	= 0x01	; .oam_dma: DMA _shadow_OAM every VBlank
+	.OAM_DMA_COMMIT	= 0x02	; .oam_dma: DMA the committed page next VBlank
  
 	.P1		= 0x00	; Joystick: 1.1.P15.P14.P13.P12.P11.P10
 	.SB		= 0x01	; Serial IO data buffer
@@ -94,6 +97,11 @@
 	.M_NO_INTERP	= 0x08	; Disables special character interpretation
 
 	.MBC1_ROM_PAGE	= 0x2000 ; Address to write to for MBC1 switching
+
+	;; Hardware models, as found in __cpu
+	.DMG_TYPE	= 0x01	; Original GB or Super GB
+	.MGB_TYPE	= 0xFF	; Pocket GB or Super GB 2
+	.CGB_TYPE	= 0x11	; Color GB
 	
 	;; Status codes for IO
 	.IO_IDLE	= 0x00
@@ -147,6 +155,7 @@
 	.globl	.STACK
 	.globl	_shadow_OAM
 	.globl	.refresh_OAM
+	.globl	.oam_dma
 
 	;; Main user routine	
 	.globl	_main
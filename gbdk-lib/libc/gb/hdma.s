@@ -0,0 +1,177 @@
+	.include	"global.s"
+
+	.title	"CGB VRAM DMA"
+	.module	HDMA
+
+	.globl	.copy_vram
+
+	;; The CGB copies to VRAM in 16 byte blocks with HDMA1-5:
+	;;  - general DMA stops the CPU until all blocks are copied, so it
+	;;    is only started while the LCD is off or in VBlank
+	;;  - HBlank DMA copies one block at the start of each HBlank
+	;; Anything DMA can't do (DMG, unaligned data, source in VRAM or
+	;; echo RAM) is copied by the CPU instead.
+
+	.HDMA_VBL_BLOCKS	= 8	; Blocks per general DMA in VBlank, less than a line
+
+	;; BANKED: checked
+	.area	_BASE
+
+	;; Copy to VRAM, with DMA on CGB
+	;; void hdma_copy(void *dst, const void *src, UINT16 len, UINT8 bank)
+_hdma_copy::			; Non-banked
+	PUSH	BC
+	LDH	A,(__current_bank)
+	PUSH	AF		; Bank to switch back to
+
+	LDA	HL,12(SP)	; Skip bank, registers, return address, dst, src and len
+	LD	A,(HL)
+	OR	A
+	JR	Z,1$		; Source isn't in another bank
+	LDH	(__current_bank),A	; Interrupts switch back to this one
+	LD	(.MBC1_ROM_PAGE),A
+1$:
+	LDA	HL,6(SP)	; DE = dst
+	LD	A,(HL+)
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A
+	LD	A,(HL+)		; BC = src
+	LD	C,A
+	LD	A,(HL+)
+	LD	B,A
+	LD	A,(HL+)		; HL = len
+	LD	H,(HL)
+	LD	L,A
+	OR	H
+	JP	Z,9$		; Nothing to copy
+
+	LD	A,(__cpu)
+	CP	#.CGB_TYPE
+	JP	NZ,8$		; No DMA
+	LD	A,C		; DMA copies aligned 16 byte blocks
+	OR	E
+	OR	L
+	AND	#0x0F
+	JP	NZ,8$
+	LD	A,B		; from ROM, SRAM or WRAM
+	CP	#0xE0
+	JP	NC,8$
+	AND	#0xE0
+	CP	#0x80
+	JP	Z,8$
+
+	LD	A,L		; HL = len / 16 blocks
+	SWAP	A
+	AND	#0x0F
+	LD	L,A
+	LD	A,H
+	SWAP	A
+	LD	H,A
+	AND	#0xF0
+	OR	L
+	LD	L,A
+	LD	A,H
+	AND	#0x0F
+	LD	H,A
+
+	;; BC = source, DE = destination, HL = blocks left
+2$:
+	LD	A,B
+	LDH	(.HDMA1),A
+	LD	A,C
+	LDH	(.HDMA2),A
+	LD	A,D
+	LDH	(.HDMA3),A
+	LD	A,E
+	LDH	(.HDMA4),A
+
+	LDH	A,(.LCDC)
+	RRA
+	LD	A,#128		; LCD off, up to 2048 bytes at once
+	JR	NC,3$
+	LDH	A,(.LY)
+	CP	#144
+	JR	C,4$		; Drawing
+	CP	#153
+	LD	A,#.HDMA_VBL_BLOCKS
+	JR	C,3$		; VBlank
+	XOR	A		; Last line, next frame starts
+	JR	4$
+
+3$:				; General DMA, the CPU waits
+	CALL	.hdma_blocks
+	DEC	A
+	LDH	(.HDMA5),A
+	INC	A
+	JR	6$
+
+4$:				; HBlank DMA, one block per line until VBlank
+	CPL			; A = 144 - LY
+	ADD	#145
+	CALL	.hdma_blocks
+	PUSH	AF
+	DEC	A
+	OR	#0x80
+	LDH	(.HDMA5),A
+5$:
+	LDH	A,(.HDMA5)	; Reads 0xFF once done
+	INC	A
+	JR	NZ,5$
+	POP	AF
+
+6$:				; A blocks copied
+	PUSH	AF
+	CPL			; HL -= A
+	INC	A
+	ADD	L
+	LD	L,A
+	JR	C,7$
+	DEC	H
+7$:
+	POP	AF
+	SWAP	A
+	PUSH	HL		; Blocks left
+	LD	L,A
+	AND	#0x0F
+	LD	H,A
+	LD	A,L
+	AND	#0xF0
+	LD	L,A		; HL = bytes copied
+	PUSH	HL
+	ADD	HL,BC
+	LD	B,H
+	LD	C,L
+	POP	HL
+	ADD	HL,DE
+	LD	D,H
+	LD	E,L
+	POP	HL
+	LD	A,H
+	OR	L
+	JR	NZ,2$
+	JR	9$
+
+8$:				; Copy with the CPU
+	PUSH	DE
+	LD	D,H
+	LD	E,L
+	POP	HL
+	CALL	.copy_vram
+
+9$:
+	POP	AF
+	LDH	(__current_bank),A
+	LD	(.MBC1_ROM_PAGE),A
+	POP	BC
+	RET
+
+	;; A = min(A, HL), for A > 0 and HL > 0
+.hdma_blocks:
+	INC	H
+	DEC	H
+	RET	NZ
+	CP	L
+	RET	C
+	LD	A,L
+	RET
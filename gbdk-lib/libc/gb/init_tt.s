@@ -24,6 +24,9 @@
 	LD	DE,#0x0400	; One whole GB Screen
 
 .init_vram::
+	LDH	A,(.LCDC)
+	RRA
+	JR	NC,6$		; LCD is off, no need to wait for STAT
 1$:
 	SRL	D
 	RR	E
@@ -61,3 +64,45 @@
 	JR	NZ, 4$
 	
 	RET
+
+6$:
+	LD	A, E		; DE % 16 bytes first
+	AND	#0x0F
+	JR	Z, 8$
+7$:
+	LD	(HL), B
+	INC	HL
+	DEC	A
+	JR	NZ, 7$
+8$:
+	LD	A, E		; Then DE / 16 blocks of 16
+	SWAP	A
+	AND	#0x0F
+	LD	E, A
+	LD	A, D
+	SWAP	A
+	LD	D, A
+	AND	#0xF0
+	OR	E
+	LD	E, A
+	LD	A, D
+	AND	#0x0F
+	LD	D, A
+	OR	E
+	RET	Z
+
+	LD	A, B
+	INC	D
+	INC	E
+	JR	10$
+9$:
+	.rept	16
+	LD	(HL+),A
+	.endm
+10$:
+	DEC	E
+	JR	NZ, 9$
+	DEC	D
+	JR	NZ, 9$
+
+	RET
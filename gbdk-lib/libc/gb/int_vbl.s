@@ -0,0 +1,16 @@
+	.include	"global.s"
+
+	;; The VBL vector, calling the handlers in .int_0x40. Only linked
+	;; when the program doesn't define ___isr_vector_VBL itself.
+
+	.globl	.int
+
+	.area	_HEADER_VBL (ABS)
+
+	.org	0x40		; VBL
+___isr_vector_VBL::
+.int_VBL:
+	PUSH	AF
+	PUSH	HL
+	LD	HL,#.int_0x40
+	JP	.int
@@ -5,6 +5,7 @@
 	.area	_HEADER_JOY (ABS)
 
 	.org	0x60		; JOY
+___isr_vector_JOY::
 .int_JOY:
 	PUSH	AF
 	PUSH	HL
@@ -4,6 +4,7 @@
 	.area	_HEADER_LCD (ABS)
 
 	.org	0x48		; LCD
+___isr_vector_LCD::
 .int_LCD:
 	JP	.int_lcd_handler
 
@@ -0,0 +1,165 @@
+	.include	"global.s"
+
+	.title	"Metasprites"
+	.module	Metasprites
+
+	;; Metasprites are tables of 4 byte entries (dy, dx, tile, props),
+	;; ended by dy = -128, written straight to _shadow_OAM. Flipped
+	;; versions mirror each offset around the origin of the metasprite:
+	;;   x - dx - 8 = (x - 7) + (dx ^ 0xFF)
+	;;   y - dy - h = (y - h + 1) + (dy ^ 0xFF), h = 8 or 16
+	;; and toggle the flip bits in props.
+
+	.METASPRITE_END	= 0x80
+
+	;; BANKED: checked
+	.area	_BASE
+
+	;; UINT8 move_metasprite(const metasprite_t *metasprite, UINT8 base_tile, UINT8 base_sprite, UINT8 x, UINT8 y)
+	;; Returns the number of sprites used
+_move_metasprite::		; Non-banked
+	PUSH	BC
+	LDA	HL,4(SP)	; Skip return address and registers
+	CALL	.metasprite_args
+	PUSH	DE		; First OAM entry
+1$:
+	LD	A,(HL+)		; Y
+	CP	#.METASPRITE_END
+	JR	Z,.metasprite_done
+	ADD	C
+	LD	(DE),A
+	INC	E
+	LD	A,(HL+)		; X
+	ADD	B
+	LD	(DE),A
+	INC	E
+	LD	A,(.metasprite_tile)	; Tile
+	ADD	(HL)
+	INC	HL
+	LD	(DE),A
+	INC	E
+	LD	A,(HL+)		; Props
+	LD	(DE),A
+	INC	E
+	JR	1$
+
+	;; UINT8 move_metasprite_hflip(const metasprite_t *metasprite, UINT8 base_tile, UINT8 base_sprite, UINT8 x, UINT8 y)
+_move_metasprite_hflip::	; Non-banked
+	LD	A,#0x20		; S_FLIPX
+	JR	.metasprite_flip
+	;; UINT8 move_metasprite_vflip(const metasprite_t *metasprite, UINT8 base_tile, UINT8 base_sprite, UINT8 x, UINT8 y)
+_move_metasprite_vflip::	; Non-banked
+	LD	A,#0x40		; S_FLIPY
+	JR	.metasprite_flip
+	;; UINT8 move_metasprite_hvflip(const metasprite_t *metasprite, UINT8 base_tile, UINT8 base_sprite, UINT8 x, UINT8 y)
+_move_metasprite_hvflip::	; Non-banked
+	LD	A,#0x60		; S_FLIPX | S_FLIPY
+.metasprite_flip:
+	PUSH	BC
+	LD	(.metasprite_props),A
+	LDA	HL,4(SP)	; Skip return address and registers
+	CALL	.metasprite_args
+
+	XOR	A
+	LD	(.metasprite_dx),A
+	LD	(.metasprite_dy),A
+	LD	A,(.metasprite_props)
+	BIT	5,A
+	JR	Z,2$
+	LD	A,#0xFF		; Mirror X
+	LD	(.metasprite_dx),A
+	LD	A,B
+	SUB	#7
+	LD	B,A
+2$:
+	LD	A,(.metasprite_props)
+	BIT	6,A
+	JR	Z,3$
+	LD	A,#0xFF		; Mirror Y
+	LD	(.metasprite_dy),A
+	LDH	A,(.LCDC)	; Sprite height
+	AND	#0x20
+	LD	A,#8
+	JR	Z,21$
+	LD	A,#16
+21$:
+	CPL			; Y + 1 - height
+	INC	A
+	INC	A
+	ADD	C
+	LD	C,A
+3$:
+	PUSH	DE		; First OAM entry
+4$:
+	LD	A,(HL)		; Y
+	CP	#.METASPRITE_END
+	JR	Z,.metasprite_done
+	LD	A,(.metasprite_dy)
+	XOR	(HL)
+	INC	HL
+	ADD	C
+	LD	(DE),A
+	INC	E
+	LD	A,(.metasprite_dx)	; X
+	XOR	(HL)
+	INC	HL
+	ADD	B
+	LD	(DE),A
+	INC	E
+	LD	A,(.metasprite_tile)	; Tile
+	ADD	(HL)
+	INC	HL
+	LD	(DE),A
+	INC	E
+	LD	A,(.metasprite_props)	; Props, flip bits toggled
+	XOR	(HL)
+	INC	HL
+	LD	(DE),A
+	INC	E
+	JR	4$
+
+	;; Return the number of OAM entries written since the one on the stack
+.metasprite_done:
+	POP	HL
+	LD	A,E
+	SUB	L
+	RRCA
+	RRCA
+	LD	E,A
+	POP	BC
+	RET
+
+	;; Arguments at (HL) to HL = metasprite, DE = first OAM entry,
+	;; B = x, C = y and .metasprite_tile = base tile
+.metasprite_args:
+	LD	A,(HL+)
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A
+	LD	A,(HL+)
+	LD	(.metasprite_tile),A
+	LD	A,(HL+)		; Base sprite
+	PUSH	AF
+	LD	A,(HL+)
+	LD	B,A
+	LD	C,(HL)
+	LD	H,D
+	LD	L,E
+	POP	AF
+	ADD	A		; OAM entries are 4 bytes, in one page
+	ADD	A
+	ADD	#<_shadow_OAM
+	LD	E,A
+	LD	D,#>_shadow_OAM
+	RET
+
+	.area	_BSS
+
+.metasprite_tile:
+	.ds	0x01		; Added to the tile of each entry
+.metasprite_dx:
+	.ds	0x01		; 0xFF to mirror the offsets, 0x00 otherwise
+.metasprite_dy:
+	.ds	0x01
+.metasprite_props:
+	.ds	0x01		; Flip bits toggled in each entry
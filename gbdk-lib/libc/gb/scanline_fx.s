@@ -0,0 +1,207 @@
+	.include	"global.s"
+
+	.title	"Scanline effects"
+	.module	ScanlineFx
+
+	;; Sets SCX, SCY, WX and BGP from a table of runs, each five bytes:
+	;; the four values, then how many lines they are kept for. A run of
+	;; 0 lines lasts to the bottom of the screen.
+	;;
+	;; The VBL handler loads the first run and sets LYC to its last
+	;; line. The LY = LYC interrupt there, in mode 2, loads the next run
+	;; into registers, waits for HBlank and writes them, BGP and WX
+	;; first, then sets LYC to the last line of that run. The writes
+	;; land a few cycles into HBlank however long mode 3 is. One line
+	;; runs are shown from the same interrupt, waiting for each HBlank.
+	;;
+	;; The module owns the LCD vector, so it can't be linked together
+	;; with add_LCD() or ISR_VECTOR(LCD, ...).
+
+	.STAT_LYC_INT	= 0x02	; STAT: interrupt when LY = LYC
+	.FX_NO_LYC	= 0xFF	; LYC value LY never reaches
+
+	.area	_HEADER_LCD (ABS)
+
+	.org	0x48		; LCD
+___isr_vector_LCD::
+	JP	.fx_isr
+
+	.area	_GSINIT
+
+	XOR	A
+	LD	(.fx_pending),A
+
+	;; BANKED: checked
+	.area	_BASE
+
+	;; void scanline_fx_start(const scanline_run_t *table)
+_scanline_fx_start::		; Non-banked
+	PUSH	BC
+	LDA	HL,4(SP)	; Skip return address and registers
+	CALL	.fx_set_next
+	LD	A,#.FX_NO_LYC	; Nothing until VBL loads the first run
+	LDH	(.LYC),A
+	LD	BC,#.fx_vbl
+	CALL	.add_VBL
+	LDH	A,(.STAT)
+	OR	#.STAT_LYC_INT
+	LDH	(.STAT),A
+	LDH	A,(.IE)
+	OR	#.LCD_IFLAG
+	LDH	(.IE),A
+	POP	BC
+	RET
+
+	;; void scanline_fx_show(const scanline_run_t *table)
+_scanline_fx_show::		; Non-banked
+	LDA	HL,2(SP)	; Skip return address
+	;; Fall through
+
+	;; Table at (HL) to .fx_next, used from the next VBlank
+.fx_set_next:
+	XOR	A		; Not while VBL could read half of it
+	LD	(.fx_pending),A
+	LD	A,(HL+)
+	LD	(.fx_next),A
+	LD	A,(HL)
+	LD	(.fx_next+1),A
+	LD	A,#1
+	LD	(.fx_pending),A
+	RET
+
+	;; void scanline_fx_stop(void)
+_scanline_fx_stop::		; Non-banked
+	PUSH	BC
+	LDH	A,(.STAT)
+	AND	#(0xFF - .STAT_LYC_INT)
+	LDH	(.STAT),A
+	LDH	A,(.IE)
+	AND	#(0xFF - .LCD_IFLAG)
+	LDH	(.IE),A
+	LD	BC,#.fx_vbl
+	CALL	.remove_VBL
+	POP	BC
+	RET
+
+	;; LY = LYC, the last line of a run: show the next run from the next line
+.fx_isr:
+	PUSH	AF
+	PUSH	HL
+	PUSH	BC
+	PUSH	DE
+	LD	HL,#.fx_run
+	LD	A,(HL+)
+	LD	H,(HL)
+	LD	L,A
+1$:
+	LD	A,(HL+)
+	LD	B,A		; SCX
+	LD	A,(HL+)
+	LD	C,A		; SCY
+	LD	A,(HL+)
+	LD	D,A		; WX
+	LD	A,(HL+)
+	LD	E,A		; BGP
+	LD	A,(HL+)		; Lines in the run
+	PUSH	HL		; Next run
+	LD	H,A
+	LDH	A,(.LY)
+	LD	L,A		; The line whose HBlank shows the run
+
+	WAIT_STAT		; Mode 3 of this line is over
+
+	LD	A,E
+	LDH	(.BGP),A
+	LD	A,D
+	LDH	(.WX),A
+	LD	A,B
+	LDH	(.SCX),A
+	LD	A,C
+	LDH	(.SCY),A
+
+	LD	D,H		; Lines in the run
+	LD	E,L		; This line
+	POP	HL
+	DEC	D
+	JR	NZ,3$
+	LD	A,E
+	CP	#142
+	JR	NC,3$		; No next line on the screen
+	;; A one line run: the next one is due in the next HBlank, too soon
+	;; for another interrupt, so wait for it here
+2$:
+	LDH	A,(.STAT)
+	AND	#0x40		; Mode 2 of the next line
+	JR	Z,2$
+	JR	1$
+3$:
+	LD	A,L
+	LD	(.fx_run),A
+	LD	A,H
+	LD	(.fx_run+1),A
+	INC	D
+	JR	Z,4$		; Lasts to the bottom
+	LD	A,E
+	ADD	D		; Last line of the run
+	JR	C,4$
+	CP	#143
+	JR	C,5$
+4$:
+	LD	A,#.FX_NO_LYC	; No more changes this frame
+5$:
+	LDH	(.LYC),A
+	POP	DE
+	POP	BC
+	POP	HL
+	POP	AF
+	RETI
+
+	;; VBL: show the first run, of the next table if there is one
+.fx_vbl:
+	LD	A,(.fx_pending)
+	OR	A
+	JR	Z,1$
+	XOR	A
+	LD	(.fx_pending),A
+	LD	A,(.fx_next)
+	LD	(.fx_table),A
+	LD	A,(.fx_next+1)
+	LD	(.fx_table+1),A
+1$:
+	LD	A,(.fx_table)
+	LD	L,A
+	LD	A,(.fx_table+1)
+	LD	H,A
+	LD	A,(HL+)
+	LDH	(.SCX),A
+	LD	A,(HL+)
+	LDH	(.SCY),A
+	LD	A,(HL+)
+	LDH	(.WX),A
+	LD	A,(HL+)
+	LDH	(.BGP),A
+	LD	A,(HL+)		; Lines in the run
+	LD	B,A
+	LD	A,L
+	LD	(.fx_run),A
+	LD	A,H
+	LD	(.fx_run+1),A
+	LD	A,B
+	DEC	A		; Last line of the run, 0 lines gives 0xFF
+	CP	#143
+	JR	C,2$
+	LD	A,#.FX_NO_LYC	; Lasts to the bottom
+2$:
+	LDH	(.LYC),A
+	RET
+
+	.area	_BSS
+
+.fx_table:
+	.ds	0x02		; Table being shown
+.fx_next:
+	.ds	0x02		; Table to show from the next VBlank
+.fx_pending:
+	.ds	0x01		; Non zero when .fx_next is new
+.fx_run:
+	.ds	0x02		; Run to show after LY = LYC
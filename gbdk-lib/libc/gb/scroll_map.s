@@ -0,0 +1,425 @@
+	.include	"global.s"
+
+	.title	"Map scrolling"
+	.module	ScrollMap
+
+	;; Streams a tile map of any size through the 32x32 background map,
+	;; used as a ring: map tile (x, y) goes to (x % 32, y % 32), and SCX
+	;; and SCY are the camera position % 256. Each move only uploads the
+	;; columns and rows of tiles which have just come into view.
+
+	.SCROLL_MAP_VIEW_W	= 160 - 1	; Pixels shown past the camera position
+	.SCROLL_MAP_VIEW_H	= 144 - 1
+
+	;; BANKED: checked
+	.area	_BASE
+
+	;; Set up the map and show it from camera position x, y
+	;; void scroll_map_set(const UINT8 *tiles, UINT16 width, UINT16 height, UINT8 bank, UINT16 x, UINT16 y)
+_scroll_map_set::		; Non-banked
+	PUSH	BC
+	LDA	HL,4(SP)	; Skip return address and registers
+	LD	DE,#.scroll_map_tiles
+	.rept	11		; tiles, width, height, bank, x, y
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	DE
+	.endm
+	CALL	.scroll_map_bank
+	CALL	.scroll_map_view
+
+	LD	HL,#.scroll_map_cols+4	; Upload all the columns shown
+	LD	A,(HL+)
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A
+	LD	A,(HL+)
+	LD	C,A
+	LD	B,(HL)
+	CALL	.scroll_map_columns
+	JR	.scroll_map_done
+
+	;; Move the camera to x, y
+	;; void scroll_map_move(UINT16 x, UINT16 y)
+_scroll_map_move::		; Non-banked
+	PUSH	BC
+	LDA	HL,4(SP)	; Skip return address and registers
+	LD	DE,#.scroll_map_x
+	.rept	4		; x, y
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	DE
+	.endm
+	CALL	.scroll_map_bank
+	CALL	.scroll_map_view
+
+	LD	HL,#.scroll_map_cols
+	CALL	.scroll_map_edge
+	CALL	NC,.scroll_map_columns
+	LD	HL,#.scroll_map_rows
+	CALL	.scroll_map_edge
+	CALL	NC,.scroll_map_rows_up
+
+.scroll_map_done:
+	LD	HL,#.scroll_map_cols+4	; The new view becomes the old one
+	LD	DE,#.scroll_map_cols
+	.rept	4
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	DE
+	.endm
+	LD	HL,#.scroll_map_rows+4
+	LD	DE,#.scroll_map_rows
+	.rept	4
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	DE
+	.endm
+
+	LD	A,(.scroll_map_x)
+	LDH	(.SCX),A
+	LD	A,(.scroll_map_y)
+	LDH	(.SCY),A
+
+	POP	AF		; Bank saved by .scroll_map_bank
+	LDH	(__current_bank),A
+	LD	(.MBC1_ROM_PAGE),A
+	POP	BC
+	RET
+
+	;; Switch to the bank of the map, leaving the current bank on the stack
+.scroll_map_bank:
+	POP	HL		; Return address
+	LDH	A,(__current_bank)
+	PUSH	AF
+	LD	A,(.scroll_map_bank_nb)
+	OR	A
+	JR	Z,1$		; Map isn't in another bank
+	LDH	(__current_bank),A	; Interrupts switch back to this one
+	LD	(.MBC1_ROM_PAGE),A
+1$:
+	JP	(HL)
+
+	;; Work out the tiles shown from .scroll_map_x, .scroll_map_y
+.scroll_map_view:
+	LD	HL,#.scroll_map_x
+	LD	A,(HL+)
+	LD	E,A
+	LD	D,(HL)
+	LD	BC,#.SCROLL_MAP_VIEW_W
+	LD	HL,#.scroll_map_width
+	CALL	.scroll_map_span
+	LD	HL,#.scroll_map_cols+4
+	CALL	.scroll_map_put
+
+	LD	HL,#.scroll_map_y
+	LD	A,(HL+)
+	LD	E,A
+	LD	D,(HL)
+	LD	BC,#.SCROLL_MAP_VIEW_H
+	LD	HL,#.scroll_map_height
+	CALL	.scroll_map_span
+	LD	HL,#.scroll_map_rows+4
+	;; Fall through
+
+	;; Store DE then BC at (HL)
+.scroll_map_put:
+	LD	A,E
+	LD	(HL+),A
+	LD	A,D
+	LD	(HL+),A
+	LD	A,C
+	LD	(HL+),A
+	LD	(HL),B
+	RET
+
+	;; Tiles shown from camera position DE, with BC = pixels shown - 1,
+	;; clipped to the map size at (HL)
+	;; Returns DE = first tile, BC = last tile
+.scroll_map_span:
+	LD	A,(HL+)		; Last tile of the map
+	LD	H,(HL)
+	LD	L,A
+	DEC	HL
+	PUSH	HL
+	LD	H,D
+	LD	L,E
+	ADD	HL,BC
+	LD	B,H
+	LD	C,L
+	.rept	3		; Pixels to tiles
+	SRL	B
+	RR	C
+	SRL	D
+	RR	E
+	.endm
+	POP	HL
+	LD	A,L		; Clip to the map
+	SUB	C
+	LD	A,H
+	SBC	B
+	RET	NC
+	LD	B,H
+	LD	C,L
+	RET
+
+	;; Tiles which have come into view along one axis, from the old and
+	;; new first and last tiles shown at (HL)
+	;; Returns carry set if there are none, or DE = first, BC = last
+.scroll_map_edge:
+	LD	A,(HL+)
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A
+	PUSH	DE		; Old first
+	LD	A,(HL+)
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A
+	PUSH	DE		; Old last
+	LD	A,(HL+)
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A		; DE = new first
+	LD	A,(HL+)
+	LD	C,A
+	LD	B,(HL)		; BC = new last
+
+	POP	HL		; Moved on if old last < new last
+	LD	A,L
+	SUB	C
+	LD	A,H
+	SBC	B
+	JR	NC,1$
+	POP	AF		; Old first isn't needed
+	INC	HL		; From max(old last + 1, new first) to new last
+	LD	A,L
+	SUB	E
+	LD	A,H
+	SBC	D
+	JR	C,2$
+	LD	D,H
+	LD	E,L
+2$:
+	AND	A		; Carry clear
+	RET
+
+1$:
+	POP	HL		; Moved back if new first < old first
+	LD	A,E
+	SUB	L
+	LD	A,D
+	SBC	H
+	CCF
+	RET	C		; Nothing new
+	DEC	HL		; From new first to min(old first - 1, new last)
+	LD	A,L
+	SUB	C
+	LD	A,H
+	SBC	B
+	RET	NC
+	LD	B,H
+	LD	C,L
+	AND	A		; Carry clear
+	RET
+
+	;; Upload the columns DE to BC of the map, over the rows shown
+.scroll_map_columns:
+	PUSH	BC
+	PUSH	DE
+	CALL	.scroll_map_column
+	POP	DE
+	POP	BC
+	LD	A,E
+	CP	C
+	JR	NZ,1$
+	LD	A,D
+	CP	B
+	RET	Z
+1$:
+	INC	DE
+	JR	.scroll_map_columns
+
+	;; Upload the rows DE to BC of the map, over the columns shown
+.scroll_map_rows_up:
+	PUSH	BC
+	PUSH	DE
+	CALL	.scroll_map_row
+	POP	DE
+	POP	BC
+	LD	A,E
+	CP	C
+	JR	NZ,1$
+	LD	A,D
+	CP	B
+	RET	Z
+1$:
+	INC	DE
+	JR	.scroll_map_rows_up
+
+	;; Upload column DE of the map, over the rows shown
+.scroll_map_column:
+	LD	B,D		; BC = column
+	LD	C,E
+	LD	HL,#.scroll_map_rows+4
+	LD	A,(HL+)		; DE = first row shown
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A
+	LD	A,(HL)		; Tiles = last row - first row + 1
+	SUB	E
+	INC	A
+	LD	(.scroll_map_count),A
+	CALL	.scroll_map_vram
+	PUSH	HL
+	CALL	.scroll_map_addr
+	ADD	HL,BC
+	LD	D,H
+	LD	E,L
+	POP	HL
+	LD	A,(.scroll_map_width)
+	LD	C,A
+	LD	A,(.scroll_map_width+1)
+	LD	B,A
+1$:
+	WAIT_STAT
+	LD	A,(DE)
+	LD	(HL),A
+
+	LD	A,E		; Next row of the map
+	ADD	C
+	LD	E,A
+	LD	A,D
+	ADC	B
+	LD	D,A
+
+	LD	A,L		; Next row of VRAM, and wrap around
+	ADD	#0x20
+	LD	L,A
+	JR	NC,2$
+	INC	H
+	LD	A,H
+	AND	#0x03
+	JR	NZ,2$
+	LD	A,H
+	SUB	#0x04
+	LD	H,A
+2$:
+	LD	A,(.scroll_map_count)
+	DEC	A
+	LD	(.scroll_map_count),A
+	JR	NZ,1$
+	RET
+
+	;; Upload row DE of the map, over the columns shown
+.scroll_map_row:
+	LD	HL,#.scroll_map_cols+4
+	LD	A,(HL+)		; BC = first column shown
+	LD	C,A
+	LD	A,(HL+)
+	LD	B,A
+	LD	A,(HL)		; Tiles = last column - first column + 1
+	SUB	C
+	INC	A
+	LD	(.scroll_map_count),A
+	CALL	.scroll_map_vram
+	PUSH	HL
+	CALL	.scroll_map_addr
+	ADD	HL,BC
+	LD	D,H
+	LD	E,L
+	POP	HL
+	LD	A,(.scroll_map_count)
+	LD	B,A
+1$:
+	WAIT_STAT
+	LD	A,(DE)
+	LD	(HL),A
+	INC	DE
+
+	INC	L		; Next column, and wrap around
+	LD	A,L
+	AND	#0x1F
+	JR	NZ,2$
+	LD	A,L
+	SUB	#0x20
+	LD	L,A
+2$:
+	DEC	B
+	JR	NZ,1$
+	RET
+
+	;; HL = address in the background map of row E, column C
+.scroll_map_vram:
+	LDH	A,(.LCDC)
+	AND	#0x10		; 0x9800 or 0x9C00
+	RRCA
+	RRCA
+	OR	#0x98
+	LD	H,A
+	LD	A,E		; + 32 * (row % 32)
+	RRCA
+	RRCA
+	RRCA
+	LD	L,A
+	AND	#0x03
+	OR	H
+	LD	H,A
+	LD	A,L
+	AND	#0xE0
+	LD	L,A
+	LD	A,C		; + column % 32
+	AND	#0x1F
+	OR	L
+	LD	L,A
+	RET
+
+	;; HL = address in the map of row DE, keeps BC
+.scroll_map_addr:
+	PUSH	BC
+	LD	HL,#.scroll_map_width
+	LD	A,(HL+)
+	LD	C,A
+	LD	B,(HL)
+	LD	HL,#.scroll_map_tiles
+	LD	A,(HL+)
+	LD	H,(HL)
+	LD	L,A
+1$:
+	LD	A,D
+	OR	E
+	JR	Z,3$
+	SRL	D
+	RR	E
+	JR	NC,2$
+	ADD	HL,BC
+2$:
+	SLA	C
+	RL	B
+	JR	1$
+3$:
+	POP	BC
+	RET
+
+	.area	_BSS
+
+	;; Set from the arguments of scroll_map_set, in the same order
+.scroll_map_tiles:
+	.ds	0x02		; Map, one byte per tile, row after row
+.scroll_map_width:
+	.ds	0x02		; Size in tiles
+.scroll_map_height:
+	.ds	0x02
+.scroll_map_bank_nb:
+	.ds	0x01		; ROM bank of the map, 0 for the current one
+.scroll_map_x:
+	.ds	0x02		; Camera position in pixels
+.scroll_map_y:
+	.ds	0x02
+
+.scroll_map_cols:
+	.ds	0x08		; First and last column shown, old then new
+.scroll_map_rows:
+	.ds	0x08		; First and last row shown, old then new
+.scroll_map_count:
+	.ds	0x01		; Tiles left to upload in a column or row
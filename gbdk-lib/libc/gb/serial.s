@@ -9,6 +9,7 @@
 	.area	_HEADER_SIO (ABS)
 
 	.org	0x58		; SIO
+___isr_vector_SIO::
 .int_SIO:
 	PUSH	AF
 	PUSH	HL
@@ -0,0 +1,235 @@
+	.include	"global.s"
+
+	;; CGB tile attributes, in VRAM bank 1 behind the tile maps.
+	;; Each of the bkg and win maps can have a 32x32 byte mirror of its
+	;; attributes in WRAM, kept up to date by the functions here, so
+	;; that reading them back doesn't wait for STAT.
+
+	.globl	.set_xy_btt, .set_xy_wtt
+	.globl	.get_xy_btt, .get_xy_wtt
+
+	.area	_GSINIT
+
+	XOR	A
+	LD	HL,#.attr_bkg_mirror
+	LD	(HL+),A
+	LD	(HL+),A
+	LD	(HL+),A
+	LD	(HL),A
+
+	;; BANKED:	checked
+	.area	_BASE
+
+	;; void set_bkg_attributes_mirror(UINT8 *mirror)
+_set_bkg_attributes_mirror::	; Non-banked
+	LD	DE,#.attr_bkg_mirror
+	JR	.attr_set_mirror
+	;; void set_win_attributes_mirror(UINT8 *mirror)
+_set_win_attributes_mirror::	; Non-banked
+	LD	DE,#.attr_win_mirror
+.attr_set_mirror:
+	LDA	HL,2(SP)	; Skip return address
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	DE
+	LD	A,(HL)
+	LD	(DE),A
+	RET
+
+	;; void set_bkg_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *attrs)
+_set_bkg_attributes::		; Non-banked
+	PUSH	BC
+	LDA	HL,4(SP)	; Skip return address and registers
+	CALL	.attr_args
+	LD	A,#1
+	LDH	(.VBK),A
+	CALL	.set_xy_btt
+	LD	HL,#.attr_bkg_mirror
+	JR	.attr_put
+
+	;; void set_win_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *attrs)
+_set_win_attributes::		; Non-banked
+	PUSH	BC
+	LDA	HL,4(SP)	; Skip return address and registers
+	CALL	.attr_args
+	LD	A,#1
+	LDH	(.VBK),A
+	CALL	.set_xy_wtt
+	LD	HL,#.attr_win_mirror
+.attr_put:
+	XOR	A
+	LDH	(.VBK),A
+	CALL	.attr_mirror_put
+	POP	BC
+	RET
+
+	;; void get_bkg_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *attrs)
+_get_bkg_attributes::		; Non-banked
+	PUSH	BC
+	LDA	HL,4(SP)	; Skip return address and registers
+	CALL	.attr_args
+	LD	HL,#.attr_bkg_mirror
+	CALL	.attr_mirror
+	JR	NZ,.attr_get_mirror
+	LD	A,#1		; No mirror, read VRAM
+	LDH	(.VBK),A
+	CALL	.attr_regs
+	CALL	.get_xy_btt
+	JR	.attr_get_done
+
+	;; void get_win_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *attrs)
+_get_win_attributes::		; Non-banked
+	PUSH	BC
+	LDA	HL,4(SP)	; Skip return address and registers
+	CALL	.attr_args
+	LD	HL,#.attr_win_mirror
+	CALL	.attr_mirror
+	JR	NZ,.attr_get_mirror
+	LD	A,#1		; No mirror, read VRAM
+	LDH	(.VBK),A
+	CALL	.attr_regs
+	CALL	.get_xy_wtt
+.attr_get_done:
+	XOR	A
+	LDH	(.VBK),A
+	POP	BC
+	RET
+.attr_get_mirror:
+	CALL	.attr_mirror_get
+	POP	BC
+	RET
+
+	;; Arguments x, y, w, h, attrs at (HL) to .attr_x... and to the
+	;; registers for .set_xy_btt: D = x, E = y, H = w, L = h, BC = attrs
+.attr_args::
+	LD	D,H
+	LD	E,L
+	LD	HL,#.attr_x
+	LD	C,#6
+	RST	0x30
+.attr_regs:
+	LD	HL,#.attr_x
+	LD	A,(HL+)
+	LD	D,A
+	LD	A,(HL+)
+	LD	E,A
+	LD	A,(HL+)
+	LD	B,A
+	LD	A,(HL+)
+	LD	C,A
+	LD	A,(HL+)
+	LD	H,(HL)
+	LD	L,A
+	PUSH	HL		; BC = attrs, HL = WH
+	LD	H,B
+	LD	L,C
+	POP	BC
+	RET
+
+	;; Mirror pointer at (HL) to DE, Z if there isn't one
+.attr_mirror:
+	LD	A,(HL+)
+	LD	E,A
+	LD	D,(HL)
+	OR	D
+	RET
+
+	;; Copy the rectangle in .attr_x... to and from the mirror at DE
+	.macro	ATTR_MIRROR_COPY get
+	LD	A,(.attr_h)
+	OR	A
+	RET	Z
+	LD	C,A
+	LD	A,(.attr_buf)
+	LD	L,A
+	LD	A,(.attr_buf+1)
+	LD	H,A
+	LD	A,(.attr_y)
+	LD	(.attr_row),A
+1$:
+	PUSH	BC
+	PUSH	DE
+	PUSH	HL
+	LD	A,(.attr_row)	; DE = mirror + 32 * (row % 32) + x % 32
+	AND	#0x1F
+	LD	L,A
+	LD	H,#0
+	ADD	HL,HL
+	ADD	HL,HL
+	ADD	HL,HL
+	ADD	HL,HL
+	ADD	HL,HL
+	ADD	HL,DE
+	LD	A,(.attr_x)
+	AND	#0x1F
+	LD	C,A
+	ADD	L
+	LD	E,A
+	ADC	H
+	SUB	E
+	LD	D,A
+	POP	HL		; HL = buffer
+	LD	A,(.attr_w)
+	OR	A
+	JR	Z,4$
+	LD	B,A
+2$:
+	.if	get
+	LD	A,(DE)
+	LD	(HL+),A
+	.else
+	LD	A,(HL+)
+	LD	(DE),A
+	.endif
+	INC	DE
+	INC	C		; Wrap around at the end of the row
+	BIT	5,C
+	JR	Z,3$
+	LD	C,#0
+	LD	A,E
+	SUB	#0x20
+	LD	E,A
+	JR	NC,3$
+	DEC	D
+3$:
+	DEC	B
+	JR	NZ,2$
+4$:
+	POP	DE
+	POP	BC
+	LD	A,(.attr_row)
+	INC	A
+	LD	(.attr_row),A
+	DEC	C
+	JR	NZ,1$
+	RET
+	.endm
+
+	;; Copy .attr_buf to the mirror at (HL), if there is one
+.attr_mirror_put::
+	CALL	.attr_mirror
+	RET	Z
+	ATTR_MIRROR_COPY 0
+
+	;; Copy the mirror at DE to .attr_buf
+.attr_mirror_get:
+	ATTR_MIRROR_COPY 1
+
+	.area	_BSS
+
+.attr_bkg_mirror::
+	.ds	0x02		; Mirror of the bkg attributes, 0 for none
+.attr_win_mirror::
+	.ds	0x02		; Mirror of the win attributes, 0 for none
+.attr_x::
+	.ds	0x01		; Rectangle being copied
+.attr_y::
+	.ds	0x01
+.attr_w::
+	.ds	0x01
+.attr_h::
+	.ds	0x01
+.attr_buf::
+	.ds	0x02		; Attributes in the rectangle, row after row
+.attr_row:
+	.ds	0x01		; Row of the map being copied
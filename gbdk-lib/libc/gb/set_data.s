@@ -33,6 +33,10 @@ _set_sprite_data::
 	ld a, e
 	and #0xF0 ; Get low bits only
 	ld e, a
+
+	ldh a, (.LCDC)
+	rra
+	jr nc, 3$ ; LCD is off, no need to wait for STAT
 2$:
 	; Wrap from past $97FF to $8800 onwards
 	; This can be reduced to "bit 4 must be clear if bit 3 is set"
@@ -61,4 +65,24 @@ _set_sprite_data::
 	jr nz, 2$
 	
 	pop bc
-	ret
\ No newline at end of file
+	ret
+
+3$:
+	bit 3, d
+	jr z, 4$
+	res 4, d
+4$:
+	.rept 15
+		ld a, (hl+)
+		ld (de), a
+		inc e ; inc de
+	.endm
+	ld a, (hl+)
+	ld (de), a
+	inc de
+
+	dec c
+	jr nz, 3$
+
+	pop bc
+	ret
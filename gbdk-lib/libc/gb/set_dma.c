@@ -0,0 +1,80 @@
+#include <gb/gb.h>
+#include <gb/cgb.h>
+
+/* Tiles 0-255 are at 0x8000 for sprites and with LCDC bit 3 set,
+   otherwise 0-127 are at 0x9000 and 128-255 wrap around to 0x8800 */
+static void dma_tile_data(UINT8 block_8000, UINT8 first_tile, UINT8 nb_tiles, unsigned char *data, UINT8 bank)
+{
+  UINT16 left = nb_tiles ? nb_tiles : 256U;
+  UINT16 run;
+  UINT8 *dst;
+
+  while(left) {
+    if(block_8000) {
+      dst = (UINT8 *)0x8000U + ((UINT16)first_tile << 4);
+      run = 256U - first_tile;
+    } else if(first_tile < 128U) {
+      dst = (UINT8 *)0x9000U + ((UINT16)first_tile << 4);
+      run = 128U - first_tile;
+    } else {
+      dst = (UINT8 *)0x8800U + ((UINT16)(first_tile - 128U) << 4);
+      run = 256U - first_tile;
+    }
+    if(run > left)
+      run = left;
+    hdma_copy(dst, data, run << 4, bank);
+    data += run << 4;
+    first_tile += (UINT8)run;
+    left -= run;
+  }
+}
+
+/* Full width rows are one block of the map, anything else is copied
+   a row at a time, split in two where the row wraps around the map */
+static void dma_tiles(UINT8 *map, UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles, UINT8 bank)
+{
+  UINT8 *row;
+  UINT8 run;
+
+  x &= 0x1FU;
+  y &= 0x1FU;
+  if(x == 0U && w == 0x20U) {
+    run = 0x20U - y;
+    if(run > h)
+      run = h;
+    hdma_copy(map + ((UINT16)y << 5), tiles, (UINT16)run << 5, bank);
+    if(run < h)
+      hdma_copy(map, tiles + ((UINT16)run << 5), (UINT16)(h - run) << 5, bank);
+    return;
+  }
+  for(; h; h--, y++, tiles += w) {
+    row = map + ((UINT16)(y & 0x1FU) << 5);
+    run = 0x20U - x;
+    if(run >= w) {
+      hdma_copy(row + x, tiles, w, bank);
+    } else {
+      hdma_copy(row + x, tiles, run, bank);
+      hdma_copy(row, tiles + run, w - run, bank);
+    }
+  }
+}
+
+void set_bkg_data_dma(UINT8 first_tile, UINT8 nb_tiles, unsigned char *data, UINT8 bank) NONBANKED
+{
+  dma_tile_data(LCDC_REG & 0x08U, first_tile, nb_tiles, data, bank);
+}
+
+void set_sprite_data_dma(UINT8 first_tile, UINT8 nb_tiles, unsigned char *data, UINT8 bank) NONBANKED
+{
+  dma_tile_data(1, first_tile, nb_tiles, data, bank);
+}
+
+void set_bkg_tiles_dma(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles, UINT8 bank) NONBANKED
+{
+  dma_tiles((LCDC_REG & 0x10U) ? (UINT8 *)0x9C00U : (UINT8 *)0x9800U, x, y, w, h, tiles, bank);
+}
+
+void set_win_tiles_dma(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles, UINT8 bank) NONBANKED
+{
+  dma_tiles((LCDC_REG & 0x02U) ? (UINT8 *)0x9C00U : (UINT8 *)0x9800U, x, y, w, h, tiles, bank);
+}
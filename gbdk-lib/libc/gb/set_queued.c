@@ -0,0 +1,76 @@
+#include <gb/gb.h>
+#include <gb/vram_queue.h>
+
+/* Queue a copy, waiting for the VBL interrupt to make room if needed */
+static void queue(void *dst, const void *src, UINT16 len)
+{
+  while(!vram_queue(dst, src, len))
+    wait_vbl_done();
+}
+
+/* Tiles 0-255 are at 0x8000 for sprites and with LCDC bit 3 set,
+   otherwise 0-127 are at 0x9000 and 128-255 wrap around to 0x8800 */
+static void queue_tile_data(UINT8 block_8000, UINT8 first_tile, UINT8 nb_tiles, unsigned char *data)
+{
+  UINT16 left = nb_tiles ? nb_tiles : 256U;
+  UINT16 run;
+  UINT8 *dst;
+
+  while(left) {
+    if(block_8000) {
+      dst = (UINT8 *)0x8000U + ((UINT16)first_tile << 4);
+      run = 256U - first_tile;
+    } else if(first_tile < 128U) {
+      dst = (UINT8 *)0x9000U + ((UINT16)first_tile << 4);
+      run = 128U - first_tile;
+    } else {
+      dst = (UINT8 *)0x8800U + ((UINT16)(first_tile - 128U) << 4);
+      run = 256U - first_tile;
+    }
+    if(run > left)
+      run = left;
+    queue(dst, data, run << 4);
+    data += run << 4;
+    first_tile += (UINT8)run;
+    left -= run;
+  }
+}
+
+/* One copy per row, split in two where the row wraps around the map */
+static void queue_tiles(UINT8 *map, UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles)
+{
+  UINT8 *row;
+  UINT8 run;
+
+  x &= 0x1FU;
+  for(; h; h--, y++, tiles += w) {
+    row = map + ((UINT16)(y & 0x1FU) << 5);
+    run = 0x20U - x;
+    if(run >= w) {
+      queue(row + x, tiles, w);
+    } else {
+      queue(row + x, tiles, run);
+      queue(row, tiles + run, w - run);
+    }
+  }
+}
+
+void set_bkg_data_queued(UINT8 first_tile, UINT8 nb_tiles, unsigned char *data) NONBANKED
+{
+  queue_tile_data(LCDC_REG & 0x08U, first_tile, nb_tiles, data);
+}
+
+void set_sprite_data_queued(UINT8 first_tile, UINT8 nb_tiles, unsigned char *data) NONBANKED
+{
+  queue_tile_data(1, first_tile, nb_tiles, data);
+}
+
+void set_bkg_tiles_queued(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles) NONBANKED
+{
+  queue_tiles((LCDC_REG & 0x10U) ? (UINT8 *)0x9C00U : (UINT8 *)0x9800U, x, y, w, h, tiles);
+}
+
+void set_win_tiles_queued(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles) NONBANKED
+{
+  queue_tiles((LCDC_REG & 0x02U) ? (UINT8 *)0x9C00U : (UINT8 *)0x9800U, x, y, w, h, tiles);
+}
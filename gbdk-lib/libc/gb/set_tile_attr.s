@@ -0,0 +1,148 @@
+	.include	"global.s"
+
+	;; Tiles and CGB attributes in one pass: each tile is written to
+	;; VRAM bank 0 and its attribute to bank 1 after the same STAT wait.
+
+	.globl	.attr_args, .attr_mirror_put
+	.globl	.attr_x, .attr_y, .attr_w, .attr_h, .attr_buf
+	.globl	.attr_bkg_mirror, .attr_win_mirror
+
+	;; BANKED:	checked
+	.area	_BASE
+
+	;; void set_bkg_tiles_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles, unsigned char *attrs)
+_set_bkg_tiles_attributes::	; Non-banked
+	PUSH	BC
+	CALL	.tile_attr_args
+	LDH	A,(.LCDC)
+	BIT	4,A
+	LD	HL,#.attr_bkg_mirror
+	JR	.tile_attr
+
+	;; void set_win_tiles_attributes(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles, unsigned char *attrs)
+_set_win_tiles_attributes::	; Non-banked
+	PUSH	BC
+	CALL	.tile_attr_args
+	LDH	A,(.LCDC)
+	BIT	1,A
+	LD	HL,#.attr_win_mirror
+.tile_attr:
+	PUSH	HL		; Mirror
+	LD	HL,#0x9800
+	JR	Z,1$
+	LD	H,#0x9C
+1$:
+	CALL	.set_xy_tt_attr
+	POP	HL
+	CALL	.attr_mirror_put
+	POP	BC
+	RET
+
+	;; Arguments to .attr_x..., tiles to .tile_attr_tiles and attrs to .attr_buf
+.tile_attr_args:
+	LDA	HL,6(SP)	; Skip return addresses and registers
+	PUSH	HL
+	CALL	.attr_args
+	LD	A,(.attr_buf)
+	LD	(.tile_attr_tiles),A
+	LD	A,(.attr_buf+1)
+	LD	(.tile_attr_tiles+1),A
+	POP	HL
+	LD	DE,#6		; attrs
+	ADD	HL,DE
+	LD	A,(HL+)
+	LD	(.attr_buf),A
+	LD	A,(HL)
+	LD	(.attr_buf+1),A
+	RET
+
+	;; Set the rectangle in .attr_x... of the map at HL from
+	;; .tile_attr_tiles in bank 0 and .attr_buf in bank 1
+.set_xy_tt_attr:
+	LD	A,(.attr_w)
+	OR	A
+	RET	Z
+	LD	A,(.attr_h)
+	OR	A
+	RET	Z
+	LD	(.tile_attr_rows),A
+
+	LD	A,(.attr_y)	; BC = HL + 0x20 * (y % 32) + x % 32
+	SWAP	A
+	RLCA
+	LD	E,A
+	AND	#0x03
+	ADD	H
+	LD	B,A
+	LD	A,(.attr_x)
+	AND	#0x1F
+	LD	C,A
+	LD	A,#0xE0
+	AND	E
+	OR	C
+	LD	C,A
+
+	LD	A,(.tile_attr_tiles)
+	LD	L,A
+	LD	A,(.tile_attr_tiles+1)
+	LD	H,A
+	LD	A,(.attr_buf)
+	LD	E,A
+	LD	A,(.attr_buf+1)
+	LD	D,A
+1$:
+	PUSH	BC		; Start of the row
+	LD	A,(.attr_w)
+	LD	(.tile_attr_left),A
+2$:
+	WAIT_STAT
+	LD	A,(HL+)		; Tile
+	LD	(BC),A
+	LD	A,#1		; Attribute
+	LDH	(.VBK),A
+	LD	A,(DE)
+	LD	(BC),A
+	XOR	A
+	LDH	(.VBK),A
+	INC	DE
+
+	INC	C		; Next column, wrapping around
+	LD	A,C
+	AND	#0x1F
+	JR	NZ,3$
+	LD	A,C
+	SUB	#0x20
+	LD	C,A
+3$:
+	LD	A,(.tile_attr_left)
+	DEC	A
+	LD	(.tile_attr_left),A
+	JR	NZ,2$
+
+	POP	BC
+	LD	A,(.tile_attr_rows)
+	DEC	A
+	RET	Z
+	LD	(.tile_attr_rows),A
+
+	LD	A,C		; Next row, wrapping around
+	ADD	#0x20
+	LD	C,A
+	JR	NC,1$
+	INC	B
+	LD	A,B
+	AND	#0x03
+	JR	NZ,1$
+	LD	A,B
+	SUB	#0x04
+	LD	B,A
+	JR	1$
+
+	.area	_BSS
+
+.tile_attr_tiles:
+	.ds	0x02		; Tiles in the rectangle, row after row
+.tile_attr_rows:
+	.ds	0x01		; Rows left
+.tile_attr_left:
+	.ds	0x01		; Tiles left in the row
@@ -0,0 +1,148 @@
+#include <gb/gb.h>
+#include <gb/shadow_map.h>
+
+/* A shadow of one 32x32 map: the tiles, a bit per dirty row, and the
+   first and last dirty column of each dirty row */
+typedef struct shadow_map_t {
+  UINT8 *tiles;
+  UINT8 dirty[4];
+  UINT8 first[32];
+  UINT8 last[32];
+} shadow_map_t;
+
+static shadow_map_t bkg_shadow, win_shadow;
+
+static void shadow_init(shadow_map_t *map, UINT8 *shadow)
+{
+  map->tiles = shadow;
+  map->dirty[0] = map->dirty[1] = map->dirty[2] = map->dirty[3] = 0U;
+}
+
+/* Mark columns first to last of row y as dirty */
+static void shadow_mark_row(shadow_map_t *map, UINT8 y, UINT8 first, UINT8 last)
+{
+  UINT8 *dirty = &map->dirty[y >> 3];
+  UINT8 bit = 1U << (y & 0x07U);
+
+  if(!(*dirty & bit)) {
+    *dirty |= bit;
+    map->first[y] = first;
+    map->last[y] = last;
+    return;
+  }
+  if(first < map->first[y])
+    map->first[y] = first;
+  if(last > map->last[y])
+    map->last[y] = last;
+}
+
+static void shadow_mark(shadow_map_t *map, UINT8 x, UINT8 y, UINT8 w, UINT8 h)
+{
+  UINT8 last;
+
+  if(!w)
+    return;
+  x &= 0x1FU;
+  last = x + w - 1U;
+  for(; h; h--, y++) {
+    if(w >= 0x20U)
+      shadow_mark_row(map, y & 0x1FU, 0U, 0x1FU);
+    else if(last < 0x20U)
+      shadow_mark_row(map, y & 0x1FU, x, last);
+    else {
+      shadow_mark_row(map, y & 0x1FU, x, 0x1FU);
+      shadow_mark_row(map, y & 0x1FU, 0U, last & 0x1FU);
+    }
+  }
+}
+
+/* Copy the tiles which differ into the shadow, marking just those cells */
+static void shadow_set_tiles(shadow_map_t *map, UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles)
+{
+  UINT8 *row;
+  UINT8 i, col, first, last;
+
+  for(; h; h--, y++) {
+    y &= 0x1FU;
+    row = map->tiles + ((UINT16)y << 5);
+    first = 0xFFU;
+    for(i = 0U, col = x & 0x1FU; i != w; i++, col = (col + 1U) & 0x1FU) {
+      if(row[col] != *tiles) {
+        row[col] = *tiles;
+        if(first == 0xFFU)
+          first = last = col;
+        else {
+          if(col < first)
+            first = col;
+          if(col > last)
+            last = col;
+        }
+      }
+      tiles++;
+    }
+    if(first != 0xFFU)
+      shadow_mark_row(map, y, first, last);
+  }
+}
+
+/* Upload the dirty part of each dirty row, and clear the dirty bits */
+static void shadow_flush(shadow_map_t *map, UINT8 win)
+{
+  UINT8 i, y, bits, first;
+
+  for(i = 0U; i != 4U; i++) {
+    bits = map->dirty[i];
+    if(!bits)
+      continue;
+    map->dirty[i] = 0U;
+    for(y = i << 3; bits; bits >>= 1, y++) {
+      if(bits & 1U) {
+        first = map->first[y];
+        if(win)
+          set_win_tiles(first, y, map->last[y] - first + 1U, 1U, map->tiles + ((UINT16)y << 5) + first);
+        else
+          set_bkg_tiles(first, y, map->last[y] - first + 1U, 1U, map->tiles + ((UINT16)y << 5) + first);
+      }
+    }
+  }
+}
+
+void set_bkg_shadow(UINT8 *shadow) NONBANKED
+{
+  shadow_init(&bkg_shadow, shadow);
+}
+
+void set_win_shadow(UINT8 *shadow) NONBANKED
+{
+  shadow_init(&win_shadow, shadow);
+}
+
+void set_bkg_shadow_tiles(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles) NONBANKED
+{
+  shadow_set_tiles(&bkg_shadow, x, y, w, h, tiles);
+}
+
+void set_win_shadow_tiles(UINT8 x, UINT8 y, UINT8 w, UINT8 h, unsigned char *tiles) NONBANKED
+{
+  shadow_set_tiles(&win_shadow, x, y, w, h, tiles);
+}
+
+void mark_bkg_shadow(UINT8 x, UINT8 y, UINT8 w, UINT8 h) NONBANKED
+{
+  shadow_mark(&bkg_shadow, x, y, w, h);
+}
+
+void mark_win_shadow(UINT8 x, UINT8 y, UINT8 w, UINT8 h) NONBANKED
+{
+  shadow_mark(&win_shadow, x, y, w, h);
+}
+
+void flush_bkg_shadow(void) NONBANKED
+{
+  shadow_flush(&bkg_shadow, 0U);
+}
+
+void flush_win_shadow(void) NONBANKED
+{
+  shadow_flush(&win_shadow, 1U);
+}
@@ -0,0 +1,468 @@
+	.include	"global.s"
+
+	.title	"Sprite multiplexing"
+	.module	SpriteMux
+
+	;; Maps a table of logical sprites onto the hardware sprites from
+	;; .mux_first on. Each update writes them in order starting from
+	;; .mux_start, then moves .mux_start on by .mux_stride, which is
+	;; about half the table and has no factor in common with its size,
+	;; so every logical sprite comes first in turn. Sprites over the 40
+	;; sprite and 10 per line limits so take turns.
+	;;
+	;; With a split line, the sprites above and below it are kept in
+	;; two bands, each with all the hardware sprites: VBlank shows the
+	;; top band, and the LCD interrupt DMAs the bottom band to OAM two
+	;; lines before the split.
+	;;   VBL: after the OAM DMA, copy the bottom band to _shadow_OAM
+	;;   LCD: DMA _shadow_OAM to OAM, copy the top band to _shadow_OAM
+	;; There are two sets of bands: the interrupts copy from the one in
+	;; .mux_shown while the update fills the other, then switches them.
+
+	.globl	.refresh_OAM, .int_0x48
+
+	.MUX_SPLIT_LEAD	= 2	; Lines before the split to start the DMA
+
+	;; A set of bands
+	.MUX_COPY	= 0	; Entries to copy to _shadow_OAM for each band
+	.MUX_TOP	= 1	; Top band of OAM entries
+	.MUX_BOTTOM	= 161	; Bottom band of OAM entries
+	.MUX_SET_SIZE	= 321
+
+	.area	_GSINIT
+
+	XOR	A
+	LD	(.mux_count),A
+	LD	(.mux_split),A
+
+	;; BANKED: checked
+	.area	_BASE
+
+	;; void sprite_mux_init(OAM_item_t *sprites, UINT8 count, UINT8 first_slot)
+_sprite_mux_init::		; Non-banked
+	LDA	HL,2(SP)	; Skip return address
+	LD	A,(HL+)
+	LD	(.mux_sprites),A
+	LD	A,(HL+)
+	LD	(.mux_sprites+1),A
+	LD	A,(HL+)
+	LD	(.mux_count),A
+	LD	E,A
+	LD	A,(HL)		; OAM entries are 4 bytes
+	ADD	A
+	ADD	A
+	LD	(.mux_first),A
+	XOR	A
+	LD	(.mux_start),A
+	LD	(.mux_used),A
+
+	LD	A,E		; Stride = count / 2 + 1, or + 2 if both are even
+	SRL	A
+	INC	A
+	BIT	0,E
+	JR	NZ,1$
+	BIT	0,A
+	JR	NZ,1$
+	INC	A
+1$:
+	CP	E		; then modulo count
+	JR	C,2$
+	SUB	E
+2$:
+	LD	(.mux_stride),A
+	RET
+
+	;; void sprite_mux_split(UINT8 line)
+_sprite_mux_split::		; Non-banked
+	PUSH	BC
+	LD	BC,#.mux_vbl
+	CALL	.remove_VBL
+	LD	BC,#.mux_lcd
+	CALL	.remove_LCD
+	LDA	HL,4(SP)	; Skip return address and registers
+	LD	A,(HL)
+	LD	HL,#.mux_split
+	LD	C,(HL)		; C = last split line
+	LD	(HL),A
+	OR	A
+	JR	NZ,2$
+
+	OR	C		; One band, no interrupts
+	JR	Z,1$
+	LDH	A,(.STAT)
+	AND	#(0xFF - 0x02)	; No LCD interrupt when LY = LYC
+	LDH	(.STAT),A
+	LD	HL,#.int_0x48
+	LD	A,(HL+)
+	OR	(HL)
+	JR	NZ,1$		; Other LCD handlers still need it
+	LDH	A,(.IE)
+	AND	#(0xFF - 0x02)	; Disable LCD interrupt
+	LDH	(.IE),A
+	JR	1$
+2$:
+	SUB	#.MUX_SPLIT_LEAD
+	LDH	(.LYC),A
+	LD	A,(.mux_first)	; Copy every entry the first time
+	RRCA
+	RRCA
+	CPL
+	ADD	#41
+	LD	(.mux_used),A
+	XOR	A		; Nothing to copy before the first update
+	LD	(.mux_shown),A
+	LD	(.mux_set0+.MUX_COPY),A
+	LD	(.mux_set1+.MUX_COPY),A
+	LD	BC,#.mux_vbl
+	CALL	.add_VBL
+	LD	BC,#.mux_lcd
+	CALL	.add_LCD
+	LDH	A,(.STAT)
+	OR	#0x02		; LCD interrupt when LY = LYC
+	LDH	(.STAT),A
+	LDH	A,(.IE)
+	OR	#0x02		; Enable LCD interrupt
+	LDH	(.IE),A
+1$:
+	POP	BC
+	RET
+
+	;; UINT8 sprite_mux_update(void)
+	;; Returns the number of sprites which didn't fit
+_sprite_mux_update::		; Non-banked
+	PUSH	BC
+	XOR	A
+	LD	(.mux_dropped),A
+	LD	(.mux_band_type),A
+
+	LD	A,(.mux_split)
+	OR	A
+	JR	NZ,1$
+	LD	A,(.mux_first)	; One band, 1 <= y < 160, straight to OAM
+	ADD	#<_shadow_OAM
+	LD	E,A
+	LD	D,#>_shadow_OAM
+	LD	C,#159
+	CALL	.mux_band
+	JR	3$
+1$:
+	LD	HL,#.mux_set1	; Fill the set not being shown
+	LD	A,(.mux_shown)
+	OR	A
+	JR	Z,11$
+	LD	HL,#.mux_set0
+11$:
+	LD	A,L
+	LD	(.mux_fill),A
+	LD	A,H
+	LD	(.mux_fill+1),A
+
+	LD	A,(.mux_split)	; Top band, 1 <= y < split + 16
+	ADD	#15
+	LD	C,A
+	LD	A,#1
+	LD	(.mux_band_type),A
+	LD	HL,#.MUX_TOP
+	CALL	.mux_fill_band
+	LD	(.mux_top_used),A
+
+	LD	A,#2		; Bottom band, split + 16 - height < y < 160
+	LD	(.mux_band_type),A
+	LDH	A,(.LCDC)
+	AND	#0x20		; 8x16 sprites
+	LD	A,(.mux_split)
+	JR	NZ,2$
+	ADD	#8
+2$:
+	INC	A
+	LD	C,A
+	LD	HL,#.MUX_BOTTOM
+	CALL	.mux_fill_band
+
+	LD	B,A		; Copy enough entries to cover both bands
+	LD	A,(.mux_top_used)	; and whatever the last update left
+	CP	B
+	JR	C,21$
+	LD	B,A
+21$:
+	LD	A,(.mux_used)
+	CP	B
+	JR	NC,22$
+	LD	A,B
+22$:
+	LD	HL,#.mux_fill
+	LD	E,(HL)
+	INC	HL
+	LD	D,(HL)
+	LD	(DE),A		; .MUX_COPY
+	LD	A,B
+	LD	(.mux_used),A
+
+	LD	A,(.mux_shown)	; Show the new set
+	XOR	#1
+	LD	(.mux_shown),A
+
+3$:
+	LD	A,(.mux_count)	; Start next time .mux_stride further on
+	LD	C,A
+	LD	A,(.mux_stride)
+	LD	B,A
+	LD	A,(.mux_start)
+	ADD	B
+	JR	C,5$
+	CP	C
+	JR	C,6$
+5$:
+	SUB	C
+6$:
+	LD	(.mux_start),A
+
+	LD	A,(.mux_dropped)
+	LD	E,A
+	POP	BC
+	RET
+
+	;; HL = the set of bands being shown
+.mux_shown_set:
+	LD	HL,#.mux_set0
+	LD	A,(.mux_shown)
+	OR	A
+	RET	Z
+	LD	HL,#.mux_set1
+	RET
+
+	;; .mux_band to offset HL in the set being filled
+.mux_fill_band:
+	LD	A,(.mux_fill)
+	ADD	L
+	LD	E,A
+	LD	A,(.mux_fill+1)
+	ADC	H
+	LD	D,A
+	;; Fall through
+
+	;; Write the logical sprites in the band set by .mux_band_type and C
+	;; (see MUX_SCAN)
+	;; to DE, starting from .mux_start, and hide the entries left over
+	;; Returns A = number of entries used
+.mux_band:
+	LD	A,(.mux_first)	; Entries = 40 - first
+	RRCA
+	RRCA
+	CPL
+	ADD	#41
+	LD	(.mux_left),A
+	PUSH	AF
+
+	LD	A,(.mux_start)	; From start to the end of the table
+	LD	L,A
+	LD	H,#0
+	ADD	HL,HL
+	ADD	HL,HL
+	LD	A,(.mux_sprites)
+	ADD	L
+	LD	L,A
+	LD	A,(.mux_sprites+1)
+	ADC	H
+	LD	H,A
+	LD	A,(.mux_start)
+	LD	B,A
+	LD	A,(.mux_count)
+	SUB	B
+	CALL	.mux_scan
+
+	LD	A,(.mux_sprites)	; Then from the start of the table
+	LD	L,A
+	LD	A,(.mux_sprites+1)
+	LD	H,A
+	LD	A,(.mux_start)
+	CALL	.mux_scan
+
+	LD	A,(.mux_left)	; Hide the rest
+	OR	A
+	JR	Z,2$
+	LD	B,A
+	XOR	A
+1$:
+	LD	(DE),A
+	INC	DE
+	INC	DE
+	INC	DE
+	INC	DE
+	DEC	B
+	JR	NZ,1$
+2$:
+	POP	AF		; Entries used = entries - entries left
+	LD	HL,#.mux_left
+	SUB	(HL)
+	RET
+
+	;; Jump to out unless the logical sprite at HL is in the band
+	.macro	MUX_IN band, out
+	LD	A,(HL)
+	.if	band - 2
+	DEC	A
+	.if	band
+	CP	C
+	.else
+	CP	#159
+	.endif
+	JR	NC,out
+	.else
+	CP	#160
+	JR	NC,out
+	CP	C
+	JR	C,out
+	.endif
+	.endm
+
+	;; Copy the logical sprites in the band to DE, one at a time
+	;; HL = logical sprites, B = number of them, and for each band:
+	;;  0, whole screen: 1 <= y < 160, C = entries left
+	;;  1, top band: y - 1 < C, entries left in .mux_left
+	;;  2, bottom band: C <= y < 160, entries left in .mux_left
+	.macro	MUX_SCAN band
+	.if	band
+	.else
+	LD	A,(.mux_left)
+	LD	C,A
+	.endif
+1$:
+	MUX_IN	band, 3$
+	.if	band
+	LD	A,(.mux_left)
+	SUB	#1
+	JR	C,2$		; Band full
+	LD	(.mux_left),A
+	.else
+	LD	A,C
+	OR	A
+	JR	Z,2$		; Band full
+	DEC	C
+	.endif
+	.rept	4
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	DE
+	.endm
+	DEC	B
+	JR	NZ,1$
+	JR	4$
+3$:
+	INC	HL
+	INC	HL
+	INC	HL
+	INC	HL
+	DEC	B
+	JR	NZ,1$
+	JR	4$
+
+2$:
+	LD	D,#1		; Count the rest dropped in D, the band is full
+5$:
+	INC	HL
+	INC	HL
+	INC	HL
+	INC	HL
+	DEC	B
+	JR	Z,6$
+	MUX_IN	band, 5$
+	INC	D
+	JR	5$
+6$:
+	LD	A,(.mux_dropped)
+	ADD	D
+	LD	(.mux_dropped),A
+4$:
+	.if	band
+	.else
+	LD	A,C
+	LD	(.mux_left),A
+	.endif
+	RET
+	.endm
+
+	;; Scan A logical sprites from HL
+.mux_scan:
+	OR	A
+	RET	Z
+	LD	B,A
+	LD	A,(.mux_band_type)
+	OR	A
+	JR	Z,.mux_scan_all
+	DEC	A
+	JP	Z,.mux_scan_top
+	JP	.mux_scan_bottom
+.mux_scan_all:
+	MUX_SCAN 0
+.mux_scan_top:
+	MUX_SCAN 1
+.mux_scan_bottom:
+	MUX_SCAN 2
+
+	;; VBL: the top band is in OAM, get the bottom one ready
+.mux_vbl:
+	CALL	.mux_shown_set
+	LD	A,(HL)		; .MUX_COPY
+	LD	BC,#.MUX_BOTTOM
+	ADD	HL,BC
+	JR	.mux_copy_band
+
+	;; LCD: show the bottom band, and get the top one ready for VBlank
+.mux_lcd:
+	CALL	.refresh_OAM
+	CALL	.mux_shown_set
+	LD	A,(HL+)		; .MUX_COPY, then .MUX_TOP
+	;; Fall through
+
+	;; Copy A entries of the band at HL to _shadow_OAM
+.mux_copy_band:
+	OR	A
+	RET	Z
+	LD	C,A
+	LD	A,(.mux_first)
+	ADD	#<_shadow_OAM
+	LD	E,A
+	LD	D,#>_shadow_OAM
+1$:
+	.rept	4
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	E
+	.endm
+	DEC	C
+	JR	NZ,1$
+	RET
+
+	.area	_BSS
+
+.mux_sprites:
+	.ds	0x02		; Logical sprites, as OAM entries
+.mux_count:
+	.ds	0x01		; Number of logical sprites
+.mux_first:
+	.ds	0x01		; Offset in OAM of the first hardware sprite used
+.mux_start:
+	.ds	0x01		; Logical sprite written first
+.mux_stride:
+	.ds	0x01		; Logical sprites .mux_start moves on each update
+.mux_split:
+	.ds	0x01		; Line between the two bands, 0 for one band
+.mux_used:
+	.ds	0x01		; Entries used in either band last update
+.mux_top_used:
+	.ds	0x01
+.mux_band_type:
+	.ds	0x01		; Band being filled, 0 whole screen, 1 top, 2 bottom
+.mux_left:
+	.ds	0x01		; Entries left in the band being filled
+.mux_dropped:
+	.ds	0x01		; Number dropped
+.mux_shown:
+	.ds	0x01		; Set of bands the interrupts copy from, 0 or 1
+.mux_fill:
+	.ds	0x02		; Set of bands being filled
+.mux_set0:
+	.ds	.MUX_SET_SIZE	; Two sets of bands
+.mux_set1:
+	.ds	.MUX_SET_SIZE
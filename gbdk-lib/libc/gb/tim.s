@@ -5,6 +5,7 @@
 	.area	_HEADER_TIM (ABS)
 
 	.org	0x50		; TIM
+___isr_vector_TIM::
 .int_TIM:
 	PUSH	AF
 	PUSH	HL
@@ -0,0 +1,330 @@
+	.include	"global.s"
+
+	.title	"VRAM transfer queue"
+	.module	VRAMQueue
+
+	;; Copies to VRAM are queued from the main loop and done by the
+	;; VBL interrupt, a few 16 byte chunks per frame, so writers never
+	;; wait for STAT. Each job is 8 bytes:
+	;;   +0 source, +2 destination, +4 length, +6 ROM bank of the source
+	;; The main loop only moves the tail and the interrupt only moves
+	;; the head, so neither needs interrupts disabled.
+
+	.VRAM_QUEUE_LEN		= 32	; Jobs, must be a power of two
+	.VRAM_QUEUE_MASK	= .VRAM_QUEUE_LEN - 1
+	.VRAM_QUEUE_BUDGET	= 10	; Default chunks per frame (160 bytes)
+	.VRAM_QUEUE_CHUNK	= 16	; Bytes copied between budget checks
+
+	.area	_GSINIT
+
+	XOR	A
+	LD	(.vram_queue_head),A
+	LD	(.vram_queue_tail),A
+	LD	A,#.VRAM_QUEUE_BUDGET
+	LD	(.vram_queue_budget),A
+	LD	BC,#.vram_queue_drain
+	CALL	.add_VBL
+
+	;; BANKED: checked
+	.area	_BASE
+
+	;; Copy queued jobs until the queue is empty, the budget for this
+	;; frame is used up or VBlank is over
+	;; Called from the VBL interrupt, which saves all registers
+.vram_queue_drain::
+	LD	A,(.vram_queue_budget)
+	LD	(.vram_queue_left),A
+	;; Fall through
+
+	;; Copy with the budget already set in .vram_queue_left, into VRAM
+	;; bank 0 whichever bank the interrupted code has selected
+.vram_queue_copy:
+	LDH	A,(.VBK)
+	PUSH	AF
+	XOR	A
+	LDH	(.VBK),A
+	CALL	.vram_queue_run
+	POP	AF
+	LDH	(.VBK),A
+	RET
+
+	;; Copy jobs until the queue is empty or the budget is used up
+.vram_queue_run:
+	LD	A,(.vram_queue_head)
+	LD	B,A
+	LD	A,(.vram_queue_tail)
+	CP	B
+	JP	Z,.vram_queue_done	; Queue is empty
+
+	LD	A,B			; HL = job at the head
+	ADD	A			; A *= 8
+	ADD	A
+	ADD	A
+	LD	HL,#.vram_queue
+	ADD_A_REG16	H, L
+
+	LD	A,(HL+)			; Source, kept on the stack for now
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A
+	PUSH	DE
+	LD	A,(HL+)			; DE = destination
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A
+	LD	A,(HL+)			; BC = length
+	LD	C,A
+	LD	A,(HL+)
+	LD	B,A
+	LD	A,(HL)			; Bank, 0 when not in switchable ROM
+	OR	A
+	JR	Z,1$
+	LD	(.MBC1_ROM_PAGE),A
+1$:
+	POP	HL			; HL = source
+
+2$:
+	LD	A,B
+	OR	C
+	JR	Z,6$			; Job done
+
+	;; One more chunk?
+	LD	A,(.vram_queue_left)
+	OR	A
+	JR	Z,.vram_queue_stop
+	DEC	A
+	LD	(.vram_queue_left),A
+	LDH	A,(.LCDC)
+	RRA
+	JR	NC,3$			; LCD is off
+	LDH	A,(.LY)			; A chunk takes under two lines, so
+	CP	#144			; start one no later than line 152
+	JR	C,.vram_queue_stop	; Drawing
+	CP	#153
+	JR	NC,.vram_queue_stop	; Too close to the next frame
+3$:
+	LD	A,B
+	OR	A
+	JR	NZ,4$
+	LD	A,C
+	CP	#.VRAM_QUEUE_CHUNK
+	JR	C,5$			; Less than a chunk left
+
+4$:
+	.rept	.VRAM_QUEUE_CHUNK
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	DE
+	.endm
+	LD	A,C
+	SUB	#.VRAM_QUEUE_CHUNK
+	LD	C,A
+	JR	NC,2$
+	DEC	B
+	JR	2$
+
+5$:					; Last C bytes of the job, C > 0
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	DE
+	DEC	C
+	JR	NZ,5$
+
+6$:
+	LD	A,(.vram_queue_head)	; Next job
+	INC	A
+	AND	#.VRAM_QUEUE_MASK
+	LD	(.vram_queue_head),A
+	JP	.vram_queue_run
+
+	;; Save how far the job at the head got, for the next frame
+.vram_queue_stop:
+	PUSH	HL			; Source
+	LD	A,(.vram_queue_head)
+	ADD	A
+	ADD	A
+	ADD	A
+	LD	HL,#.vram_queue + 2	; Destination of the job
+	ADD_A_REG16	H, L
+	LD	A,E
+	LD	(HL+),A
+	LD	A,D
+	LD	(HL+),A
+	LD	A,C
+	LD	(HL+),A
+	LD	(HL),B
+	LD	DE,#-5			; Back to the source
+	ADD	HL,DE
+	POP	DE
+	LD	A,E
+	LD	(HL+),A
+	LD	(HL),D
+
+.vram_queue_done:
+	LDH	A,(__current_bank)	; Restore the bank of the interrupted code
+	LD	(.MBC1_ROM_PAGE),A
+	RET
+
+	;; Copy everything in the queue now, used while the LCD is off
+	;; since there are no VBL interrupts to do it then
+.vram_queue_flush:
+	LD	A,#0xFF
+	LD	(.vram_queue_left),A
+	CALL	.vram_queue_copy
+	LD	A,(.vram_queue_head)
+	LD	B,A
+	LD	A,(.vram_queue_tail)
+	CP	B
+	JR	NZ,.vram_queue_flush
+	RET
+
+	;; Queue a copy to VRAM, copied right away if the LCD is off
+	;; UINT8 vram_queue(void *dst, const void *src, UINT16 len)
+	;; Returns 0 if the queue is full
+_vram_queue::			; Non-banked
+	PUSH	BC
+1$:
+	LD	A,(.vram_queue_tail)
+	LD	C,A			; C = tail
+	INC	A
+	AND	#.VRAM_QUEUE_MASK
+	LD	B,A			; B = tail after this job
+	LD	A,(.vram_queue_head)
+	CP	B
+	JR	Z,3$			; Full
+
+	LD	A,C			; DE = job at the tail
+	ADD	A
+	ADD	A
+	ADD	A
+	LD	DE,#.vram_queue
+	ADD_A_REG16	D, E
+
+	LDA	HL,6(SP)		; Skip return address, registers and dst
+	LD	A,(HL+)			; src
+	LD	(DE),A
+	INC	DE
+	LD	A,(HL)
+	LD	(DE),A
+	INC	DE
+	LDA	HL,4(SP)
+	LD	A,(HL+)			; dst
+	LD	(DE),A
+	INC	DE
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	DE
+	INC	HL
+	INC	HL
+	LD	A,(HL+)			; len
+	LD	(DE),A
+	INC	DE
+	LD	A,(HL)
+	LD	(DE),A
+	INC	DE
+
+	LDA	HL,7(SP)		; Source in switchable ROM (0x4000 - 0x7FFF)?
+	LD	A,(HL)
+	AND	#0xC0
+	CP	#0x40
+	LD	A,#0
+	JR	NZ,2$
+	LDH	A,(__current_bank)	; Copy it from the bank it is in now
+2$:
+	LD	(DE),A
+
+	LD	A,B			; Hand the job over to the interrupt
+	LD	(.vram_queue_tail),A
+
+	LDH	A,(.LCDC)
+	RRA
+	CALL	NC,.vram_queue_flush	; LCD is off
+
+	LD	E,#1
+	POP	BC
+	RET
+
+3$:
+	LDH	A,(.LCDC)
+	RRA
+	JR	C,4$			; LCD is on, try again next frame
+	CALL	.vram_queue_flush	; LCD is off, make room now
+	JR	1$
+4$:
+	LD	E,#0
+	POP	BC
+	RET
+
+	;; Wait until everything queued has been copied
+	;; void vram_queue_wait(void)
+_vram_queue_wait::		; Non-banked
+	PUSH	BC
+1$:
+	LD	A,(.vram_queue_head)
+	LD	B,A
+	LD	A,(.vram_queue_tail)
+	CP	B
+	JR	Z,3$
+	LDH	A,(.LCDC)
+	RRA
+	JR	NC,2$
+	CALL	.wait_vbl_done
+	JR	1$
+2$:
+	CALL	.vram_queue_flush	; LCD is off
+3$:
+	POP	BC
+	RET
+
+	;; Number of jobs not finished yet
+	;; UINT8 vram_queue_pending(void)
+_vram_queue_pending::		; Non-banked
+	LD	A,(.vram_queue_head)
+	LD	E,A
+	LD	A,(.vram_queue_tail)
+	SUB	E
+	AND	#.VRAM_QUEUE_MASK
+	LD	E,A
+	RET
+
+	;; Set the most bytes copied per frame, rounded up to 16 bytes
+	;; void set_vram_queue_budget(UINT16 bytes)
+_set_vram_queue_budget::	; Non-banked
+	LDA	HL,2(SP)		; Skip return address
+	LD	A,(HL+)
+	LD	H,(HL)
+	LD	L,A
+	LD	A,H
+	CP	#0x10
+	JR	NC,2$			; 4096 or more
+	LD	A,#(.VRAM_QUEUE_CHUNK - 1)
+	ADD_A_REG16	H, L
+	LD	A,H
+	CP	#0x10
+	JR	NC,2$
+	LD	A,L			; A = HL / 16
+	AND	#0xF0
+	OR	H
+	SWAP	A
+	OR	A
+	JR	NZ,1$
+	INC	A			; At least one chunk
+	JR	1$
+2$:
+	LD	A,#0xFF
+1$:
+	LD	(.vram_queue_budget),A
+	RET
+
+	.area	_BSS
+
+.vram_queue::
+	.ds	.VRAM_QUEUE_LEN * 8
+.vram_queue_head::
+	.ds	0x01		; Next job to copy, only moved by the interrupt
+.vram_queue_tail::
+	.ds	0x01		; Next free job, only moved by vram_queue()
+.vram_queue_budget::
+	.ds	0x01		; Chunks per frame
+.vram_queue_left:
+	.ds	0x01		; Chunks left this frame
@@ -0,0 +1,306 @@
+	.include	"global.s"
+
+	.title	"VRAM decompression"
+	.module	VRAMUnpack
+
+	;; Decodes data packed by gbpack straight into VRAM. One control
+	;; byte per token:
+	;;   0x00		End of data
+	;;   0x01 - 0x7F	That many literal bytes follow
+	;;   0x80 - 0xBF	Run, the next byte repeated (n & 0x3F) + 3 times
+	;;   0xC0 - 0xFF	Match, (n & 0x3F) + 3 bytes copied from the
+	;;			output, next byte + 1 bytes back
+	;; Like set_bkg_data, writing past 0x97FF carries on at 0x8800, and
+	;; matches read back across that wrap.
+
+	;; BANKED: checked
+	.area	_BASE
+
+	;; Decode from (DE) to VRAM at (HL), a whole token at a time, until
+	;; the end of the data or until more than .vram_unpack_left bytes
+	;; are written (it goes negative)
+	;; Returns A = 1 at the end of the data (DE left on the end marker),
+	;; with DE and HL where decoding stopped
+.vram_unpack::
+1$:
+	LD	A,(.vram_unpack_left+1)
+	INC	A
+	RET	Z		; Budget used up, A = 0
+	LD	A,(DE)
+	OR	A
+	JR	NZ,10$
+	INC	A		; End of the data
+	RET
+10$:
+	INC	DE
+	LD	B,A		; B = token
+	CP	#0x80
+	JR	C,2$		; Literals, length in the token
+	AND	#0x3F
+	ADD	#3
+2$:
+	LD	C,A		; C = length
+
+	LD	A,(.vram_unpack_left)	; Take it off the budget
+	SUB	C
+	LD	(.vram_unpack_left),A
+	JR	NC,3$
+	LD	A,(.vram_unpack_left+1)
+	DEC	A
+	LD	(.vram_unpack_left+1),A
+3$:
+	LD	A,B
+	ADD	A
+	JR	NC,4$		; Literals
+	ADD	A
+	JR	C,6$		; Match
+
+	LD	A,(DE)		; Run of B
+	INC	DE
+	LD	B,A
+	LDH	A,(.LCDC)
+	RRA
+	JR	C,31$		; LCD is on
+	LD	A,L
+	ADD	C
+	JR	C,31$		; Next page, may wrap to 0x8800
+	LD	A,B
+30$:
+	LD	(HL+),A
+	DEC	C
+	JR	NZ,30$
+	JR	1$
+31$:
+	WAIT_STAT
+	LD	A,B
+	LD	(HL+),A
+	LD	A,L
+	OR	A
+	CALL	Z,.vram_unpack_wrap
+	DEC	C
+	JR	NZ,31$
+	JR	1$
+
+4$:				; Literals
+	LDH	A,(.LCDC)
+	RRA
+	JR	C,41$		; LCD is on
+	LD	A,L
+	ADD	C
+	JR	C,41$		; Next page, may wrap to 0x8800
+40$:
+	LD	A,(DE)
+	LD	(HL+),A
+	INC	DE
+	DEC	C
+	JR	NZ,40$
+	JR	1$
+41$:
+	WAIT_STAT
+	LD	A,(DE)
+	LD	(HL+),A
+	INC	DE
+	LD	A,L
+	OR	A
+	CALL	Z,.vram_unpack_wrap
+	DEC	C
+	JR	NZ,41$
+	JP	1$
+
+6$:				; Match
+	LD	A,(DE)		; Offset - 1
+	INC	DE
+	PUSH	DE
+	LD	B,A
+	SCF			; DE = HL - B - 1
+	LD	A,L
+	SBC	B
+	LD	E,A
+	LD	A,H
+	SBC	#0
+	LD	D,A
+	CP	#0x88
+	JR	NC,60$
+	LD	A,(.vram_unpack_wrapped)
+	OR	A
+	JR	Z,60$
+	LD	A,D		; Back before the wrap to 0x8800
+	ADD	#0x10
+	LD	D,A
+60$:
+	LDH	A,(.LCDC)
+	RRA
+	JR	C,7$		; LCD is on
+	LD	A,L
+	ADD	C
+	JR	C,7$		; Next page, may wrap to 0x8800
+	LD	A,E
+	ADD	C
+	JR	C,7$
+61$:
+	LD	A,(DE)
+	LD	(HL+),A
+	INC	DE
+	DEC	C
+	JR	NZ,61$
+	POP	DE
+	JP	1$
+7$:
+	WAIT_STAT
+	LD	A,(DE)
+	LD	(HL+),A
+	INC	DE
+	LD	A,L
+	OR	A
+	CALL	Z,.vram_unpack_wrap
+	LD	A,E
+	OR	A
+	JR	NZ,8$
+	LD	A,D		; Source wraps the same way
+	CP	#0x98
+	JR	NZ,8$
+	LD	D,#0x88
+8$:
+	DEC	C
+	JR	NZ,7$
+	POP	DE
+	JP	1$
+
+	;; HL has just moved to a new page, carry on at 0x8800 after 0x97FF
+.vram_unpack_wrap:
+	LD	A,H
+	CP	#0x98
+	RET	NZ
+	LD	H,#0x88
+	LD	A,#1
+	LD	(.vram_unpack_wrapped),A
+	RET
+
+	;; Start decoding at (DE) to (HL), with no limit
+.vram_unpack_all:
+	XOR	A
+	LD	(.vram_unpack_wrapped),A
+	LD	A,#0x7F		; More than VRAM holds
+	LD	(.vram_unpack_left+1),A
+	JP	.vram_unpack
+
+	;; void vram_unpack(void *dst, const void *src)
+_vram_unpack::			; Non-banked
+	PUSH	BC
+	LDA	HL,4(SP)	; Skip return address and registers
+	LD	A,(HL+)		; BC = dst
+	LD	C,A
+	LD	A,(HL+)
+	LD	B,A
+	LD	A,(HL+)		; DE = src
+	LD	E,A
+	LD	D,(HL)
+	LD	H,B
+	LD	L,C
+	CALL	.vram_unpack_all
+	POP	BC
+	RET
+
+	;; void set_bkg_data_unpack(UINT8 first_tile, const void *data)
+_set_bkg_data_unpack::		; Non-banked
+	LD	D,#0x90
+	LDH	A,(.LCDC)
+	BIT	3,A
+	JR	Z,.vram_unpack_tiles
+	;; void set_sprite_data_unpack(UINT8 first_tile, const void *data)
+_set_sprite_data_unpack::	; Non-banked
+	LD	D,#0x80
+.vram_unpack_tiles:
+	PUSH	BC
+	LDA	HL,4(SP)	; Skip return address and registers
+	LD	A,(HL+)		; First tile
+	LD	C,A
+	SWAP	A		; BC = D * 256 + tile * 16
+	AND	#0x0F
+	ADD	D
+	LD	B,A
+	BIT	3,B		; Tiles 128-255 of the 0x9000 block are at 0x8800
+	JR	Z,2$
+	RES	4,B
+2$:
+	LD	A,C
+	SWAP	A
+	AND	#0xF0
+	LD	C,A
+	LD	A,(HL+)		; DE = data
+	LD	E,A
+	LD	D,(HL)
+	LD	H,B
+	LD	L,C
+	CALL	.vram_unpack_all
+	POP	BC
+	RET
+
+	;; void vram_unpack_init(vram_unpack_t *s, void *dst, const void *src)
+_vram_unpack_init::		; Non-banked
+	LDA	HL,2(SP)	; Skip return address
+	LD	A,(HL+)		; DE = s
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A
+	.rept	4		; dst, src
+	LD	A,(HL+)
+	LD	(DE),A
+	INC	DE
+	.endm
+	XOR	A		; Not past the wrap to 0x8800
+	LD	(DE),A
+	RET
+
+	;; UINT8 vram_unpack_step(vram_unpack_t *s, UINT16 bytes)
+	;; Returns 1 once all the data is decoded
+_vram_unpack_step::		; Non-banked
+	PUSH	BC
+	LDA	HL,6(SP)	; Skip return address, registers and s
+	LD	A,(HL+)		; Stop once more than bytes - 1 are written
+	SUB	#1
+	LD	(.vram_unpack_left),A
+	LD	A,(HL)
+	SBC	#0
+	LD	(.vram_unpack_left+1),A
+	LDA	HL,4(SP)
+	LD	A,(HL+)		; HL = s
+	LD	H,(HL)
+	LD	L,A
+	PUSH	HL
+	LD	A,(HL+)		; BC = dst
+	LD	C,A
+	LD	A,(HL+)
+	LD	B,A
+	LD	A,(HL+)		; DE = src
+	LD	E,A
+	LD	A,(HL+)
+	LD	D,A
+	LD	A,(HL)
+	LD	(.vram_unpack_wrapped),A
+	LD	H,B
+	LD	L,C
+	CALL	.vram_unpack
+	LD	B,H		; Save where it stopped
+	LD	C,L
+	POP	HL
+	LD	(HL),C
+	INC	HL
+	LD	(HL),B
+	INC	HL
+	LD	(HL),E
+	INC	HL
+	LD	(HL),D
+	INC	HL
+	LD	E,A		; Done?
+	LD	A,(.vram_unpack_wrapped)
+	LD	(HL),A
+	POP	BC
+	RET
+
+	.area	_BSS
+
+.vram_unpack_left:
+	.ds	0x02		; Bytes left to decode this time, 0xFFxx once done
+.vram_unpack_wrapped:
+	.ds	0x01		; Output went past 0x97FF to 0x8800
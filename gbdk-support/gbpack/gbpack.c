@@ -0,0 +1,353 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Compresses tile and map data for vram_unpack() and the
+// set_*_data_unpack() functions in gb/vram_unpack.h, which decode
+// straight into VRAM.
+//
+// Stream format, one control byte per token:
+//   0x00                 : End of data
+//   0x01 - 0x7F  (n)     : n literal bytes follow
+//   0x80 - 0xBF  (n)     : Run, the next byte repeated (n & 0x3F) + 3 times
+//   0xC0 - 0xFF  (n), o  : Match, copy (n & 0x3F) + 3 bytes from o + 1
+//                          bytes back in the output (may overlap)
+//
+// Matches are read back from VRAM, so they only reach 256 bytes back
+// (16 tiles) and runs are preferred over matches of the same length.
+
+#define EXIT_ERROR      2
+
+#define LITERAL_MAX     0x7FU
+#define RUN_MIN         3U
+#define RUN_MAX         (0x3FU + RUN_MIN)
+#define MATCH_MIN       3U
+#define MATCH_MAX       (0x3FU + MATCH_MIN)
+#define MATCH_OFFSET_MAX 256U
+
+#define TOKEN_END       0x00U
+#define TOKEN_RUN       0x80U
+#define TOKEN_MATCH     0xC0U
+
+// How the best encoding reaches a position
+typedef struct step {
+    uint32_t cost;      // Compressed bytes up to here
+    uint16_t length;    // Length of the last token
+    uint16_t offset;    // Match offset, 0 for a run, LITERAL for literals
+} step;
+
+#define STEP_LITERAL    0xFFFFU
+
+void display_help(void);
+int handle_args(int argc, char * argv[]);
+
+char * filename_in = NULL;
+char * filename_out = NULL;
+char * c_array_name = NULL;
+bool option_rle_only = false;
+bool option_decompress = false;
+bool option_verbose = false;
+
+
+void display_help(void) {
+    fprintf(stdout,
+           "gbpack input output [options]\n"
+           "\n"
+           "Options\n"
+           "-h : Show this help\n"
+           "-r : Runs only, no matches (slightly faster to decode)\n"
+           "-c <name> : Write C source with the data in array <name>\n"
+           "-d : Decompress a packed file instead (for checking)\n"
+           "-v : Show the compressed size and token counts\n"
+           "\n"
+           "Use: Compress binary tile or map data for vram_unpack() and\n"
+           "     set_bkg_data_unpack() in gb/vram_unpack.h.\n"
+           "Example: \"gbpack -c level1_tiles level1.2bpp level1_tiles.c\"\n"
+           );
+}
+
+
+int handle_args(int argc, char * argv[]) {
+
+    int i;
+
+    if( argc < 3 ) {
+        display_help();
+        return false;
+    }
+
+    // Start at first optional argument, argc is zero based
+    for (i = 1; i <= (argc -1); i++ ) {
+
+        if (argv[i][0] != '-') {
+            if (filename_in == NULL)
+                filename_in = argv[i];
+            else if (filename_out == NULL)
+                filename_out = argv[i];
+            else {
+                printf("Error: more than two files given: %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(argv[i], "-r") == 0) {
+            option_rle_only = true;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            if (i + 1 < argc)
+                c_array_name = argv[++i];
+        } else if (strcmp(argv[i], "-d") == 0) {
+            option_decompress = true;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            option_verbose = true;
+        } else if (strstr(argv[i], "-h")) {
+            display_help();
+            return false;  // Don't parse input when -h is used
+        } else {
+            printf("Error: unknown option %s\n", argv[i]);
+            return false;
+        }
+    }
+
+    if ((filename_in == NULL) || (filename_out == NULL)) {
+        printf("Error: need an input and an output file\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+static uint8_t * file_read(char * filename, uint32_t * p_size) {
+
+    FILE * in_file = fopen(filename, "rb");
+    uint8_t * data;
+    long size;
+
+    if (!in_file) {
+        printf("Problem with filename or unable to open file! %s\n", filename);
+        return NULL;
+    }
+
+    fseek(in_file, 0, SEEK_END);
+    size = ftell(in_file);
+    fseek(in_file, 0, SEEK_SET);
+
+    // One spare byte so empty files still get a buffer
+    data = (uint8_t *)malloc(size + 1);
+    if ((size < 0) || (fread(data, 1, size, in_file) != (size_t)size)) {
+        printf("Error: unable to read %s\n", filename);
+        free(data);
+        fclose(in_file);
+        return NULL;
+    }
+    fclose(in_file);
+
+    *p_size = (uint32_t)size;
+    return data;
+}
+
+
+static bool file_write(char * filename, uint8_t * data, uint32_t size) {
+
+    FILE * out_file = fopen(filename, (c_array_name) ? "w" : "wb");
+    uint32_t c;
+
+    if (!out_file) {
+        printf("Error: unable to create %s\n", filename);
+        return false;
+    }
+
+    if (c_array_name) {
+        fprintf(out_file, "/* %s, packed by gbpack from %s (%u bytes) */\n\n", c_array_name, filename_in, size);
+        fprintf(out_file, "const unsigned char %s[] = {", c_array_name);
+        for (c = 0; c < size; c++)
+            fprintf(out_file, "%s0x%02X%s", (c % 16) ? "" : "\n  ", data[c], (c + 1 < size) ? "," : "");
+        fprintf(out_file, "\n};\n");
+    } else
+        fwrite(data, 1, size, out_file);
+
+    return (fclose(out_file) == 0);
+}
+
+
+// Length of the run of data[pos] starting at pos
+static uint32_t run_length(uint8_t * data, uint32_t size, uint32_t pos) {
+
+    uint32_t len = 1;
+
+    while ((pos + len < size) && (len < RUN_MAX) && (data[pos + len] == data[pos]))
+        len++;
+    return len;
+}
+
+
+// Length of the match for data at pos with the data offset bytes back
+static uint32_t match_length(uint8_t * data, uint32_t size, uint32_t pos, uint32_t offset) {
+
+    uint32_t len = 0;
+
+    while ((pos + len < size) && (len < MATCH_MAX) && (data[pos + len] == data[pos + len - offset]))
+        len++;
+    return len;
+}
+
+
+static void step_update(step * steps, uint32_t to, uint32_t cost, uint16_t length, uint16_t offset) {
+
+    if (cost < steps[to].cost) {
+        steps[to].cost = cost;
+        steps[to].length = length;
+        steps[to].offset = offset;
+    }
+}
+
+
+// Smallest encoding, worked out front to back over every position
+static uint8_t * pack(uint8_t * data, uint32_t size, uint32_t * p_packed_size) {
+
+    step * steps = (step *)malloc((size + 1) * sizeof(step));
+    uint8_t * packed;
+    uint32_t pos, len, offset, max, out;
+    uint32_t token_count = 0, literal_count = 0, run_count = 0, match_count = 0;
+    uint32_t * order;
+
+    for (pos = 0; pos <= size; pos++)
+        steps[pos].cost = UINT32_MAX;
+    steps[0].cost = 0;
+
+    for (pos = 0; pos < size; pos++) {
+
+        for (len = 1; (len <= LITERAL_MAX) && (pos + len <= size); len++)
+            step_update(steps, pos + len, steps[pos].cost + 1 + len, len, STEP_LITERAL);
+
+        // Runs first, matches of the same cost don't replace them
+        max = run_length(data, size, pos);
+        for (len = RUN_MIN; len <= max; len++)
+            step_update(steps, pos + len, steps[pos].cost + 2, len, 0);
+
+        if (option_rle_only)
+            continue;
+
+        for (offset = 1; (offset <= MATCH_OFFSET_MAX) && (offset <= pos); offset++) {
+            max = match_length(data, size, pos, offset);
+            for (len = MATCH_MIN; len <= max; len++)
+                step_update(steps, pos + len, steps[pos].cost + 2, len, offset);
+        }
+    }
+
+    // Walk back from the end for the tokens in order
+    order = (uint32_t *)malloc((size + 1) * sizeof(uint32_t));
+    for (pos = size; pos > 0; pos -= steps[pos].length)
+        order[token_count++] = pos;
+
+    packed = (uint8_t *)malloc(steps[size].cost + 1);
+    out = 0;
+    while (token_count--) {
+        pos = order[token_count];
+        len = steps[pos].length;
+        if (steps[pos].offset == STEP_LITERAL) {
+            packed[out++] = (uint8_t)len;
+            memcpy(packed + out, data + pos - len, len);
+            out += len;
+            literal_count++;
+        } else if (steps[pos].offset == 0) {
+            packed[out++] = (uint8_t)(TOKEN_RUN | (len - RUN_MIN));
+            packed[out++] = data[pos - len];
+            run_count++;
+        } else {
+            packed[out++] = (uint8_t)(TOKEN_MATCH | (len - MATCH_MIN));
+            packed[out++] = (uint8_t)(steps[pos].offset - 1);
+            match_count++;
+        }
+    }
+    packed[out++] = TOKEN_END;
+
+    if (option_verbose)
+        printf("%u bytes packed to %u (%u%%): %u literal runs, %u runs, %u matches\n",
+               size, out, size ? (out * 100 / size) : 100, literal_count, run_count, match_count);
+
+    free(order);
+    free(steps);
+    *p_packed_size = out;
+    return packed;
+}
+
+
+// Same decoding as vram_unpack(), for checking packed files
+static uint8_t * unpack(uint8_t * packed, uint32_t packed_size, uint32_t * p_size) {
+
+    uint32_t alloc = 0x1000, size = 0, in = 0, len, offset;
+    uint8_t * data = (uint8_t *)malloc(alloc);
+    uint8_t token;
+
+    while (true) {
+        if (in >= packed_size) {
+            printf("Error: packed data ends without an end marker\n");
+            free(data);
+            return NULL;
+        }
+        token = packed[in++];
+        if (token == TOKEN_END)
+            break;
+
+        len = (token < TOKEN_RUN) ? token : (uint32_t)(token & 0x3FU) + 3;
+        if (size + len > alloc) {
+            alloc *= 2;
+            data = (uint8_t *)realloc(data, alloc);
+        }
+
+        if (token < TOKEN_RUN) {
+            if (in + len > packed_size)
+                len = packed_size - in;
+            memcpy(data + size, packed + in, len);
+            in += len;
+        } else if (in >= packed_size) {
+            len = 0;
+        } else if (token < TOKEN_MATCH) {
+            memset(data + size, packed[in++], len);
+        } else {
+            offset = (uint32_t)packed[in++] + 1;
+            if (offset > size) {
+                printf("Error: match at output byte %u goes back before the start\n", size);
+                free(data);
+                return NULL;
+            }
+            for (offset = size - offset; len; len--)
+                data[size++] = data[offset++];
+            continue;
+        }
+        size += len;
+    }
+
+    *p_size = size;
+    return data;
+}
+
+
+int main( int argc, char *argv[] )  {
+
+    int ret = EXIT_ERROR;
+    uint8_t * data_in;
+    uint8_t * data_out = NULL;
+    uint32_t size_in, size_out;
+
+    if (handle_args(argc, argv) &&
+        (data_in = file_read(filename_in, &size_in))) {
+
+        if (option_decompress)
+            data_out = unpack(data_in, size_in, &size_out);
+        else
+            data_out = pack(data_in, size_in, &size_out);
+
+        if (data_out && file_write(filename_out, data_out, size_out))
+            ret = EXIT_SUCCESS;
+
+        free(data_out);
+        free(data_in);
+    }
+
+    return ret;
+}
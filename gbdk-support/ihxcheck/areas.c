@@ -10,26 +10,24 @@
 #include <stdint.h>
 
 #include "areas.h"
+#include "context.h"
 
 #define AREA_GROW_SIZE 500
 
-area_item * arealist;
-uint32_t    arealist_size;
-uint32_t    arealist_count;
 
 
-uint32_t min(uint32_t a, uint32_t b) {
+static uint32_t min(uint32_t a, uint32_t b) {
     return (a < b) ? a : b;
 }
 
-uint32_t max(uint32_t a, uint32_t b) {
+static uint32_t max(uint32_t a, uint32_t b) {
     return (a > b) ? a : b;
 }
 
 
 // Returns size of overlap between two address ranges,
 // if zero then no overlap
-static uint32_t addrs_check_overlap(uint32_t a_start, uint32_t a_end, uint32_t b_start, uint32_t b_end) {
+static uint32_t addrs_check_overlap(ihx_context * ctx, uint32_t a_start, uint32_t a_end, uint32_t b_start, uint32_t b_end) {
 
     uint32_t size_used;
 
@@ -39,7 +37,7 @@ static uint32_t addrs_check_overlap(uint32_t a_start, uint32_t a_end, uint32_t b
     } else {
         size_used = min(b_end, a_end) - max(b_start, a_start) + 1; // Calculate minimum overlap
 
-        printf("WARNING: Multiple write of %5d bytes at 0x%x -> 0x%x (%x -> %x, %x -> %x)\n",
+        context_printf(ctx, "WARNING: Multiple write of %5d bytes at 0x%x -> 0x%x (%x -> %x, %x -> %x)\n",
                 size_used, max(b_start, a_start), min(b_end, a_end),
                 a_start, a_end, b_start, b_end);
     }
@@ -47,51 +45,115 @@ static uint32_t addrs_check_overlap(uint32_t a_start, uint32_t a_end, uint32_t b
 }
 
 
-void arealist_additem(area_item * p_area) {
+// Sort areas by start address, in the order they were added when equal
+static int area_ref_cmp_start(const void * a, const void * b) {
 
-    arealist_count++;
+    const area_ref * p_a = (const area_ref *)a;
+    const area_ref * p_b = (const area_ref *)b;
+
+    if (p_a->start != p_b->start)
+        return (p_a->start < p_b->start) ? -1 : 1;
+    return (p_a->index < p_b->index) ? -1 : 1;
+}
+
+
+// Sort overlapping pairs into the order they were found by
+// checking each added area against all areas added before it
+static int area_pair_cmp(const void * a, const void * b) {
+
+    const area_pair * p_a = (const area_pair *)a;
+    const area_pair * p_b = (const area_pair *)b;
+
+    if (p_a->later != p_b->later)
+        return (p_a->later < p_b->later) ? -1 : 1;
+    return (p_a->earlier < p_b->earlier) ? -1 : ((p_a->earlier > p_b->earlier) ? 1 : 0);
+}
+
+
+static void arealist_additem(ihx_context * ctx, area_item * p_area) {
+
+    ctx->arealist_count++;
     // Grow array if needed
-    if (arealist_count == arealist_size) {
-        arealist_size += AREA_GROW_SIZE;
-        arealist = (area_item *)realloc(arealist, arealist_size * sizeof(area_item));
+    if (ctx->arealist_count >= ctx->arealist_size) {
+        ctx->arealist_size += AREA_GROW_SIZE;
+        ctx->arealist = (area_item *)realloc(ctx->arealist, ctx->arealist_size * sizeof(area_item));
     }
 
-    arealist[arealist_count-1] = *p_area;
+    ctx->arealist[ctx->arealist_count-1] = *p_area;
 }
 
 
-void areas_init(void) {
-    arealist_count  = 0;
-    arealist_size   = AREA_GROW_SIZE;
-    arealist        = (area_item *)malloc(arealist_size * sizeof(area_item));
+void areas_init(ihx_context * ctx) {
+    ctx->arealist_count  = 0;
+    ctx->arealist_size   = AREA_GROW_SIZE;
+    ctx->arealist        = (area_item *)malloc(ctx->arealist_size * sizeof(area_item));
 }
 
 
-void areas_cleanup(void) {
-    if (arealist)
-        free (arealist);
+void areas_cleanup(ihx_context * ctx) {
+    if (ctx->arealist)
+        free (ctx->arealist);
+    ctx->arealist = NULL;
+    ctx->arealist_count = ctx->arealist_size = 0;
 }
 
 
-int areas_add(area_item * p_area) {
+void areas_add(ihx_context * ctx, area_item * p_area) {
+    arealist_additem(ctx, p_area);
+}
 
-    uint32_t c;
-    uint32_t size_used;
-    int ret = true; // default to success
 
-    // Check for overlap with existing areas
+// Check all added areas for overlaps and warn about each one
+// Returns false if any were found
+//
+// Sort-and-sweep: with the areas ordered by start address, every
+// area that starts before the current one ends overlaps it, so the
+// scan costs O(n log n) plus the number of overlaps instead of
+// comparing every pair. Warnings come out in the same order and
+// format as checking each area against the earlier ones on add.
+int areas_check_overlaps(ihx_context * ctx) {
+
+    uint32_t   c, d;
+    area_ref * sorted;
+    area_pair * pairs = NULL;
+    uint32_t   pairs_count = 0, pairs_size = 0;
+    area_item * arealist = ctx->arealist;
+    uint32_t   arealist_count = ctx->arealist_count;
+
+    if (arealist_count == 0)
+        return true;
+
+    sorted = (area_ref *)malloc(arealist_count * sizeof(area_ref));
     for (c = 0; c < arealist_count; c++) {
+        sorted[c].start = arealist[c].start;
+        sorted[c].end   = arealist[c].end;
+        sorted[c].index = c;
+    }
+    qsort(sorted, arealist_count, sizeof(area_ref), area_ref_cmp_start);
 
-        size_used = addrs_check_overlap(arealist[c].start, arealist[c].end,
-                                        p_area->start, p_area->end);
-        // Signal failure on any overlap
-        // (Keep looping to display all warnings though)
-        if (size_used > 0)
-            ret = false;
+    for (c = 0; c < arealist_count; c++) {
+        for (d = c + 1; (d < arealist_count) && (sorted[d].start <= sorted[c].end); d++) {
+            // Zero length areas end before they start
+            if (sorted[d].end < sorted[c].start)
+                continue;
+            // Grow array if needed
+            if (pairs_count == pairs_size) {
+                pairs_size += AREA_GROW_SIZE;
+                pairs = (area_pair *)realloc(pairs, pairs_size * sizeof(area_pair));
+            }
+            pairs[pairs_count].earlier = min(sorted[c].index, sorted[d].index);
+            pairs[pairs_count].later   = max(sorted[c].index, sorted[d].index);
+            pairs_count++;
+        }
     }
+    free(sorted);
 
-    // Now add the area
-    arealist_additem(p_area);
+    qsort(pairs, pairs_count, sizeof(area_pair), area_pair_cmp);
+    for (c = 0; c < pairs_count; c++)
+        addrs_check_overlap(ctx, arealist[pairs[c].earlier].start, arealist[pairs[c].earlier].end,
+                            arealist[pairs[c].later].start, arealist[pairs[c].later].end);
+    if (pairs)
+        free(pairs);
 
-    return ret;
-}
\ No newline at end of file
+    return (pairs_count == 0);
+}
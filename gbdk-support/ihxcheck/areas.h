@@ -11,9 +11,23 @@ typedef struct area_item {
     uint32_t length;
 } area_item;
 
+// Area start and end along with its position in the list, for sorting
+typedef struct area_ref {
+    uint32_t start;
+    uint32_t end;
+    uint32_t index;
+} area_ref;
+
+typedef struct area_pair {
+    uint32_t earlier;
+    uint32_t later;
+} area_pair;
+
+struct ihx_context;
 
-void areas_init(void);
-void areas_cleanup(void);
-int areas_add(area_item * p_area);
+void areas_init(struct ihx_context * ctx);
+void areas_cleanup(struct ihx_context * ctx);
+void areas_add(struct ihx_context * ctx, area_item * p_area);
+int areas_check_overlaps(struct ihx_context * ctx);
 
 #endif // _AREAS_H
\ No newline at end of file
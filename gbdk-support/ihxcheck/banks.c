@@ -0,0 +1,142 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "areas.h"
+#include "banks.h"
+#include "context.h"
+
+
+static int area_cmp_start(const void * a, const void * b) {
+
+    const area_item * p_a = (const area_item *)a;
+    const area_item * p_b = (const area_item *)b;
+
+    return (p_a->start > p_b->start) - (p_a->start < p_b->start);
+}
+
+
+// Record a free region of a bank if it's the largest one so far
+static void bank_add_hole(bank_item * p_bank, uint32_t start, uint32_t end_next) {
+
+    if (end_next - start > p_bank->hole_length) {
+        p_bank->hole_start  = start;
+        p_bank->hole_length = end_next - start;
+    }
+}
+
+
+// Add the part of an area that falls in bank_num,
+// areas must be added in order of start address
+static void bank_add_area(bank_item * p_bank, uint32_t bank_num, uint32_t start, uint32_t end) {
+
+    uint32_t bank_start = bank_num * BANK_SIZE;
+    uint32_t bank_end   = bank_start + BANK_SIZE - 1;
+
+    if (start < bank_start) start = bank_start;
+    if (end   > bank_end)   end   = bank_end;
+
+    // Only count bytes not already covered by an overlapping area
+    if (start > p_bank->next_free)
+        bank_add_hole(p_bank, p_bank->next_free, start);
+    else
+        start = p_bank->next_free;
+
+    if (end >= start) {
+        p_bank->used += end - start + 1;
+        p_bank->next_free = end + 1;
+    }
+}
+
+
+static void banks_print_text(ihx_context * ctx, bank_item * banks, uint32_t bank_count) {
+
+    uint32_t c;
+    uint32_t used_total = 0;
+
+    context_printf(ctx, "\nBank  Range                  Used    Free  Largest free           Fill\n");
+    for (c = 0; c < bank_count; c++) {
+        context_printf(ctx, "%4d  0x%06x -> 0x%06x  %6d  %6d  %6d at 0x%06x  %5.1f%%\n",
+               c, c * BANK_SIZE, (c * BANK_SIZE) + BANK_SIZE - 1,
+               banks[c].used, BANK_SIZE - banks[c].used,
+               banks[c].hole_length, banks[c].hole_start,
+               (banks[c].used * 100.0) / BANK_SIZE);
+        used_total += banks[c].used;
+    }
+    context_printf(ctx, "Total %d banks: %d bytes used, %d bytes free, %.1f%% full\n",
+           bank_count, used_total, (bank_count * BANK_SIZE) - used_total,
+           (used_total * 100.0) / (bank_count * BANK_SIZE));
+}
+
+
+static void banks_print_json(ihx_context * ctx, bank_item * banks, uint32_t bank_count) {
+
+    uint32_t c;
+    uint32_t used_total = 0;
+
+    context_printf(ctx, "{\n  \"bank_size\": %d,\n  \"banks\": [\n", BANK_SIZE);
+    for (c = 0; c < bank_count; c++) {
+        context_printf(ctx, "    {\"bank\": %d, \"start\": %d, \"end\": %d, \"used\": %d, \"free\": %d, "
+               "\"largest_free\": %d, \"largest_free_start\": %d, \"fill\": %.1f}%s\n",
+               c, c * BANK_SIZE, (c * BANK_SIZE) + BANK_SIZE - 1,
+               banks[c].used, BANK_SIZE - banks[c].used,
+               banks[c].hole_length, banks[c].hole_start,
+               (banks[c].used * 100.0) / BANK_SIZE,
+               (c + 1 < bank_count) ? "," : "");
+        used_total += banks[c].used;
+    }
+    context_printf(ctx, "  ],\n  \"total\": {\"banks\": %d, \"used\": %d, \"free\": %d, \"fill\": %.1f}\n}\n",
+           bank_count, used_total, (bank_count * BANK_SIZE) - used_total,
+           (used_total * 100.0) / (bank_count * BANK_SIZE));
+}
+
+
+// Print used and free space for every ROM bank up to the last one written
+void banks_report(ihx_context * ctx, int format) {
+
+    uint32_t c, b;
+    uint32_t bank_count = 1;
+    uint32_t sorted_count = 0;
+    area_item * sorted;
+    bank_item * banks;
+    area_item * arealist = ctx->arealist;
+    uint32_t    arealist_count = ctx->arealist_count;
+
+    // Zero length areas end before they start, leave them out
+    sorted = (area_item *)malloc((arealist_count + 1) * sizeof(area_item));
+    for (c = 0; c < arealist_count; c++) {
+        if (arealist[c].end >= arealist[c].start) {
+            sorted[sorted_count++] = arealist[c];
+            if ((arealist[c].end / BANK_SIZE) + 1 > bank_count)
+                bank_count = (arealist[c].end / BANK_SIZE) + 1;
+        }
+    }
+    qsort(sorted, sorted_count, sizeof(area_item), area_cmp_start);
+
+    banks = (bank_item *)calloc(bank_count, sizeof(bank_item));
+    for (b = 0; b < bank_count; b++)
+        banks[b].next_free = b * BANK_SIZE;
+
+    // Split areas that span more than one bank
+    for (c = 0; c < sorted_count; c++)
+        for (b = sorted[c].start / BANK_SIZE; b <= sorted[c].end / BANK_SIZE; b++)
+            bank_add_area(&banks[b], b, sorted[c].start, sorted[c].end);
+
+    // Free space after the last area in each bank
+    for (b = 0; b < bank_count; b++)
+        bank_add_hole(&banks[b], banks[b].next_free, (b + 1) * BANK_SIZE);
+
+    if (format == REPORT_JSON)
+        banks_print_json(ctx, banks, bank_count);
+    else
+        banks_print_text(ctx, banks, bank_count);
+
+    free(banks);
+    free(sorted);
+}
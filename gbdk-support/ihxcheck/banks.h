@@ -0,0 +1,26 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+#ifndef _BANKS_H
+#define _BANKS_H
+
+#define BANK_SIZE       0x4000U
+
+#define REPORT_NONE     0
+#define REPORT_TEXT     1
+#define REPORT_JSON     2
+
+typedef struct bank_item {
+    uint32_t used;
+    uint32_t next_free;     // First address after the last area seen
+    uint32_t hole_start;    // Start of the largest free region
+    uint32_t hole_length;
+} bank_item;
+
+
+struct ihx_context;
+
+void banks_report(struct ihx_context * ctx, int format);
+
+#endif // _BANKS_H
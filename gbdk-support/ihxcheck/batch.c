@@ -0,0 +1,135 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+#include "context.h"
+#include "batch.h"
+
+// Small thread pool for checking many files at once (-j)
+//
+// Each worker takes the next unchecked job until none are left.
+// Jobs keep all of their state in their own context, the only
+// thing shared between workers is the index of the next job.
+
+#define BATCH_THREADS_MAX 64
+
+typedef struct batch_pool {
+    batch_job * jobs;
+    uint32_t    job_count;
+    batch_func  func;
+#ifdef _WIN32
+    volatile LONG next;
+#else
+    uint32_t    next;
+    pthread_mutex_t lock;
+#endif
+} batch_pool;
+
+
+int batch_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+#endif
+}
+
+
+// Returns index of the next job to run
+static uint32_t batch_next(batch_pool * p_pool) {
+#ifdef _WIN32
+    return (uint32_t)(InterlockedIncrement(&p_pool->next) - 1);
+#else
+    uint32_t n;
+    pthread_mutex_lock(&p_pool->lock);
+    n = p_pool->next++;
+    pthread_mutex_unlock(&p_pool->lock);
+    return n;
+#endif
+}
+
+
+#ifdef _WIN32
+static DWORD WINAPI batch_worker(LPVOID p_arg) {
+#else
+static void * batch_worker(void * p_arg) {
+#endif
+    batch_pool * p_pool = (batch_pool *)p_arg;
+    uint32_t n;
+
+    while ((n = batch_next(p_pool)) < p_pool->job_count)
+        p_pool->func(&p_pool->jobs[n]);
+
+    return 0;
+}
+
+
+// Run func on every job using up to thread_count threads
+void batch_run(batch_job * jobs, uint32_t job_count, uint32_t thread_count, batch_func func) {
+
+    batch_pool pool;
+    uint32_t c, started = 0;
+#ifdef _WIN32
+    HANDLE threads[BATCH_THREADS_MAX];
+#else
+    pthread_t threads[BATCH_THREADS_MAX];
+#endif
+
+    pool.jobs      = jobs;
+    pool.job_count = job_count;
+    pool.func      = func;
+    pool.next      = 0;
+#ifndef _WIN32
+    pthread_mutex_init(&pool.lock, NULL);
+#endif
+
+    if (thread_count > job_count)
+        thread_count = job_count;
+    if (thread_count > BATCH_THREADS_MAX)
+        thread_count = BATCH_THREADS_MAX;
+
+    // Workers beyond the first run in their own threads,
+    // the calling thread is always one of the workers
+    for (c = 1; c < thread_count; c++) {
+#ifdef _WIN32
+        threads[started] = CreateThread(NULL, 0, batch_worker, &pool, 0, NULL);
+        if (threads[started] == NULL)
+            break;
+#else
+        if (pthread_create(&threads[started], NULL, batch_worker, &pool) != 0)
+            break;
+#endif
+        started++;
+    }
+
+    batch_worker(&pool);
+
+    for (c = 0; c < started; c++) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[c], INFINITE);
+        CloseHandle(threads[c]);
+#else
+        pthread_join(threads[c], NULL);
+#endif
+    }
+
+#ifndef _WIN32
+    pthread_mutex_destroy(&pool.lock);
+#endif
+}
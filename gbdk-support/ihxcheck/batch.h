@@ -0,0 +1,19 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+#ifndef _BATCH_H
+#define _BATCH_H
+
+typedef struct batch_job {
+    char *      filename;
+    ihx_context ctx;
+    int         ret;
+} batch_job;
+
+typedef void (*batch_func)(batch_job * p_job);
+
+int  batch_cpu_count(void);
+void batch_run(batch_job * jobs, uint32_t job_count, uint32_t thread_count, batch_func func);
+
+#endif // _BATCH_H
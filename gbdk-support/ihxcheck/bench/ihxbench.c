@@ -0,0 +1,380 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+
+// Benchmark for ihxcheck: writes a synthetic .ihx, times one or two
+// ihxcheck builds on it and compares what they print.
+//
+// The address space is split into separate areas (one 32 byte gap after
+// each) filled with 32 byte records of random data, plus a few records
+// written twice for the overlap check. To compare against an older
+// parser, build ihxcheck from a checkout before the change and pass it
+// as the second program.
+//
+// Overlap check, many areas in an 8 MB ROM:
+//   ihxbench -a 131072 ../ihxcheck /path/to/old/ihxcheck
+// Record parser throughput, 32 MB in one area without overlaps:
+//   ihxbench -s 32 -a 0 -n ../ihxcheck /path/to/old/ihxcheck
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/time.h>
+#endif
+
+#define RECORD_MAX      32U
+#define AREA_GAP        32U
+#define OVERLAP_COUNT   3
+#define PROGRAMS_MAX    2
+
+uint32_t option_size_mb = 8;
+uint32_t option_areas = 32768;
+bool option_overlaps = true;
+int option_runs = 3;
+bool option_keep = false;
+char * filename_ihx = (char *)"ihxbench.ihx";
+char * programs[PROGRAMS_MAX];
+int program_count = 0;
+
+uint32_t rand_state = 1;
+uint32_t address_upper;
+
+
+static void display_help(void) {
+    fprintf(stdout,
+           "ihxbench [options] ihxcheck [old_ihxcheck]\n"
+           "\n"
+           "Options\n"
+           "-h : Show this help\n"
+           "-s <MB> : ROM address space to fill, default 8\n"
+           "-a <count> : Number of separate areas, default 32768, 0 for a single area\n"
+           "-n : No deliberate overlaps (default is %d)\n"
+           "-r <runs> : Run each program this many times and keep the fastest, default 3\n"
+           "-o <file.ihx> : Name of the generated file, default ihxbench.ihx\n"
+           "-k : Keep the generated file and the outputs\n"
+           "\n"
+           "Use: Write a synthetic .ihx, time each ihxcheck on it (in s and MB/s of .ihx)\n"
+           "     and check that both print the same warnings, in any order.\n"
+           "Example: \"ihxbench -s 32 -a 0 -n ../ihxcheck old/ihxcheck\"\n",
+           OVERLAP_COUNT);
+}
+
+
+static int handle_args(int argc, char * argv[]) {
+
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strstr(argv[i], "-h") == argv[i]) {
+            display_help();
+            return false;
+        } else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+            option_size_mb = strtoul(argv[++i], NULL, 0);
+        } else if ((strcmp(argv[i], "-a") == 0) && (i + 1 < argc)) {
+            option_areas = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-n") == 0) {
+            option_overlaps = false;
+        } else if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc)) {
+            option_runs = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc)) {
+            filename_ihx = argv[++i];
+        } else if (strcmp(argv[i], "-k") == 0) {
+            option_keep = true;
+        } else if ((argv[i][0] != '-') && (program_count < PROGRAMS_MAX)) {
+            programs[program_count++] = argv[i];
+        } else {
+            printf("Error: unknown option %s\n", argv[i]);
+            display_help();
+            return false;
+        }
+    }
+
+    if (program_count == 0) {
+        display_help();
+        return false;
+    }
+    if ((option_size_mb == 0) || (option_size_mb > 128) || (option_runs < 1)) {
+        printf("Error: size must be 1 to 128 MB and runs at least 1\n");
+        return false;
+    }
+    if ((option_areas != 0) &&
+        ((option_size_mb * 1024U * 1024U) / option_areas < AREA_GAP + 1)) {
+        printf("Error: too many areas for %u MB\n", option_size_mb);
+        return false;
+    }
+    return true;
+}
+
+
+// Wall clock time in seconds
+static double bench_clock(void) {
+#ifdef _WIN32
+    FILETIME ft;
+    unsigned long long t;
+
+    GetSystemTimeAsFileTime(&ft);
+    t = ((unsigned long long)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    return t / 1e7;  // 100 ns units
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+#endif
+}
+
+
+// Same sequence on every platform, unlike rand()
+static uint8_t rand_byte(void) {
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return (uint8_t)rand_state;
+}
+
+
+static void record_write(FILE * out_file, uint16_t address, uint8_t type, uint8_t * data, uint32_t length) {
+
+    uint8_t checksum = (uint8_t)(length + (address >> 8) + (address & 0xFF) + type);
+    uint32_t c;
+
+    fprintf(out_file, ":%02X%04X%02X", length, address, type);
+    for (c = 0; c < length; c++) {
+        fprintf(out_file, "%02X", data[c]);
+        checksum += data[c];
+    }
+    fprintf(out_file, "%02X\n", (uint8_t)(0x100 - checksum) & 0xFF);
+}
+
+
+// Data record at a 32 bit address, with an extended linear address record when needed
+static void data_write(FILE * out_file, uint32_t address, uint8_t * data, uint32_t length) {
+
+    uint8_t upper[2];
+
+    if ((address >> 16) != address_upper) {
+        address_upper = address >> 16;
+        upper[0] = (address_upper >> 8) & 0xFF;
+        upper[1] = address_upper & 0xFF;
+        record_write(out_file, 0, 4, upper, 2);
+    }
+    record_write(out_file, address & 0xFFFF, 0, data, length);
+}
+
+
+// Returns the number of data bytes written, 0 on error
+static uint32_t ihx_generate(void) {
+
+    FILE * out_file = fopen(filename_ihx, "w");
+    uint32_t size = option_size_mb * 1024U * 1024U;
+    uint32_t stride = option_areas ? size / option_areas : size;
+    uint32_t fill = option_areas ? stride - AREA_GAP : size;
+    uint32_t area_start, address, length, c;
+    uint32_t total = 0;
+    uint8_t data[RECORD_MAX];
+    // Across the end of a record, at the start of the first one and inside
+    // one. The high one goes first so the EOF record follows a low address.
+    const uint32_t overlaps[OVERLAP_COUNT] = { (size / 2) + 0x40U, 0x100U, 0x4010U };
+
+    if (!out_file) {
+        printf("Error: unable to write %s\n", filename_ihx);
+        return 0;
+    }
+
+    address_upper = 0;
+    for (area_start = 0; area_start + fill <= size; area_start += stride) {
+        for (address = area_start; address < area_start + fill; address += length) {
+            length = area_start + fill - address;
+            if (length > RECORD_MAX)
+                length = RECORD_MAX;
+            // Records don't cross a 64K boundary, as in the linker output
+            if ((address & 0xFFFFU) + length > 0x10000U)
+                length = 0x10000U - (address & 0xFFFFU);
+            for (c = 0; c < length; c++)
+                data[c] = rand_byte();
+            data_write(out_file, address, data, length);
+            total += length;
+        }
+    }
+
+    if (option_overlaps) {
+        memset(data, 0, sizeof(data));
+        for (c = 0; c < OVERLAP_COUNT; c++)
+            data_write(out_file, overlaps[c], data, 16);
+    }
+
+    record_write(out_file, 0, 1, NULL, 0);  // EOF
+    if (fclose(out_file) != 0) {
+        printf("Error: unable to write %s\n", filename_ihx);
+        return 0;
+    }
+    return total;
+}
+
+
+static int compare_lines(const void * a, const void * b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+
+static long file_size(char * filename) {
+
+    FILE * in_file = fopen(filename, "rb");
+    long size;
+
+    if (!in_file)
+        return -1;
+    fseek(in_file, 0, SEEK_END);
+    size = ftell(in_file);
+    fclose(in_file);
+    return size;
+}
+
+
+// Reads a whole file, NULL on error. Caller frees.
+static char * file_read(char * filename) {
+
+    long size = file_size(filename);
+    FILE * in_file = fopen(filename, "rb");
+    char * buf = NULL;
+
+    if (in_file && (size >= 0) && (buf = malloc(size + 1))) {
+        if (fread(buf, 1, size, in_file) != (size_t)size) {
+            free(buf);
+            buf = NULL;
+        } else
+            buf[size] = '\0';
+    }
+    if (in_file) fclose(in_file);
+    return buf;
+}
+
+
+// Splits buf into lines in place and sorts them. Returns the line count, -1 on error
+static int lines_sorted(char * buf, char *** p_lines) {
+
+    char ** lines;
+    char * p;
+    int count = 0;
+
+    for (p = buf; *p; p++)
+        if (*p == '\n')
+            count++;
+    if (!(lines = malloc((count + 1) * sizeof(char *))))
+        return -1;
+    count = 0;
+    for (p = strtok(buf, "\r\n"); p; p = strtok(NULL, "\r\n"))
+        lines[count++] = p;
+    qsort(lines, count, sizeof(char *), compare_lines);
+    *p_lines = lines;
+    return count;
+}
+
+
+// Same lines in any order: the old parser prints overlaps as it finds them
+static bool files_match(char * filename_a, char * filename_b) {
+
+    char * buf_a = file_read(filename_a);
+    char * buf_b = file_read(filename_b);
+    char ** lines_a = NULL;
+    char ** lines_b = NULL;
+    int count_a = -1, count_b = -1, c;
+    bool match = false;
+
+    if (buf_a && buf_b) {
+        count_a = lines_sorted(buf_a, &lines_a);
+        count_b = lines_sorted(buf_b, &lines_b);
+    }
+    if ((count_a >= 0) && (count_a == count_b)) {
+        match = true;
+        for (c = 0; c < count_a; c++)
+            if (strcmp(lines_a[c], lines_b[c]) != 0)
+                match = false;
+    }
+    free(lines_a);
+    free(lines_b);
+    free(buf_a);
+    free(buf_b);
+    return match;
+}
+
+
+// Fastest of the runs in seconds, or a negative value if the program failed to start
+static double program_time(char * program, char * filename_out) {
+
+    char command[4096];
+    double start, elapsed, best = -1.0;
+    int run, status;
+
+    snprintf(command, sizeof(command), "\"%s\" \"%s\" > \"%s\" 2>&1", program, filename_ihx, filename_out);
+    for (run = 0; run < option_runs; run++) {
+        start = bench_clock();
+        status = system(command);
+        elapsed = bench_clock() - start;
+        // ihxcheck exits with 1 when it finds problems, anything else is a failure
+        if ((status == -1) || (file_size(filename_out) <= 0)) {
+            printf("Error: unable to run %s (status %d)\n", program, status);
+            return -1.0;
+        }
+        if ((best < 0) || (elapsed < best))
+            best = elapsed;
+    }
+    return best;
+}
+
+
+int main( int argc, char *argv[] )  {
+
+    char filename_out[PROGRAMS_MAX][1024];
+    double seconds;
+    uint32_t data_bytes;
+    long ihx_bytes;
+    int c;
+    int ret = EXIT_FAILURE;
+
+    if (!handle_args(argc, argv))
+        return EXIT_FAILURE;
+
+    if ((data_bytes = ihx_generate()) == 0)
+        return EXIT_FAILURE;
+    ihx_bytes = file_size(filename_ihx);
+    printf("%s: %ld bytes, %u bytes of data in %u MB, %u area%s, %d overlaps\n",
+           filename_ihx, ihx_bytes, data_bytes, option_size_mb,
+           option_areas ? option_areas : 1, (option_areas == 1 || option_areas == 0) ? "" : "s",
+           option_overlaps ? OVERLAP_COUNT : 0);
+
+    for (c = 0; c < program_count; c++)
+        snprintf(filename_out[c], sizeof(filename_out[c]), "%s.%d.txt", filename_ihx, c + 1);
+
+    for (c = 0; c < program_count; c++) {
+        seconds = program_time(programs[c], filename_out[c]);
+        if (seconds < 0)
+            goto cleanup;
+        printf("%-32s %8.3f s %8.1f MB/s\n", programs[c], seconds,
+               (seconds > 0) ? (ihx_bytes / (1024.0 * 1024.0)) / seconds : 0.0);
+    }
+
+    ret = EXIT_SUCCESS;
+    if (program_count == PROGRAMS_MAX) {
+        if (files_match(filename_out[0], filename_out[1]))
+            printf("Both printed the same output\n");
+        else {
+            printf("Outputs differ: %s %s\n", filename_out[0], filename_out[1]);
+            option_keep = true;
+            ret = EXIT_FAILURE;
+        }
+    }
+
+cleanup:
+    if (!option_keep) {
+        remove(filename_ihx);
+        for (c = 0; c < program_count; c++)
+            remove(filename_out[c]);
+    }
+    return ret;
+}
@@ -0,0 +1,71 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "context.h"
+#include "banks.h"
+
+#define OUT_GROW_SIZE   4096
+
+
+void context_init(ihx_context * ctx) {
+    memset(ctx, 0, sizeof(ihx_context));
+    ctx->option_report = REPORT_NONE;
+    rom_options_init(&ctx->rom_opts);
+}
+
+
+void context_cleanup(ihx_context * ctx) {
+    areas_cleanup(ctx);
+    map_file_cleanup(ctx);
+    rom_cleanup(ctx);
+    if (ctx->out_buf)
+        free(ctx->out_buf);
+    ctx->out_buf = NULL;
+    ctx->out_len = ctx->out_size = 0;
+}
+
+
+// printf() to stdout, or to the context's buffer when checking in parallel
+void context_printf(ihx_context * ctx, const char * format, ...) {
+
+    va_list args;
+    int len;
+
+    va_start(args, format);
+    if (!ctx->out_buffered) {
+        vprintf(format, args);
+        va_end(args);
+        return;
+    }
+    len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (len <= 0)
+        return;
+
+    // Grow buffer if needed
+    if (ctx->out_len + len + 1 > ctx->out_size) {
+        ctx->out_size = ctx->out_len + len + 1 + OUT_GROW_SIZE;
+        ctx->out_buf = (char *)realloc(ctx->out_buf, ctx->out_size);
+    }
+
+    va_start(args, format);
+    vsnprintf(ctx->out_buf + ctx->out_len, len + 1, format, args);
+    va_end(args);
+    ctx->out_len += len;
+}
+
+
+// Write out anything collected in the buffer
+void context_flush(ihx_context * ctx) {
+    if (ctx->out_len)
+        fwrite(ctx->out_buf, 1, ctx->out_len, stdout);
+    ctx->out_len = 0;
+}
@@ -0,0 +1,51 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+#ifndef _CONTEXT_H
+#define _CONTEXT_H
+
+#include "areas.h"
+#include "map_file.h"
+#include "rom_file.h"
+
+// Everything needed to check one .ihx file, so that
+// several files can be checked at the same time
+typedef struct ihx_context {
+    // Areas written by the .ihx
+    area_item * arealist;
+    uint32_t    arealist_size;
+    uint32_t    arealist_count;
+
+    // ROM areas from the linker map (-m), if loaded
+    map_area *  maplist;
+    uint32_t    maplist_size;
+    uint32_t    maplist_count;
+
+    // Upper 16 bits of address space from the last extended linear address record
+    uint32_t    address_upper;
+
+    bool        option_warnings_as_errors;
+    int         option_report;
+    bool        option_no_checks;   // -n: only write the ROM
+
+    // ROM image written along with the checks (-o), when rom_filename is set
+    char *      rom_filename;
+    rom_options rom_opts;
+    rom_image   rom;
+    bool        rom_in_memory;      // Build and finalize the image without writing it (romdiff)
+
+    // When buffered, output is collected here instead of going to stdout
+    bool        out_buffered;
+    char *      out_buf;
+    size_t      out_len;
+    size_t      out_size;
+} ihx_context;
+
+
+void context_init(ihx_context * ctx);
+void context_cleanup(ihx_context * ctx);
+void context_printf(ihx_context * ctx, const char * format, ...);
+void context_flush(ihx_context * ctx);
+
+#endif // _CONTEXT_H
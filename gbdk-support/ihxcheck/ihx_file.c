@@ -5,12 +5,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <unistd.h>
 #include <stdbool.h>
 #include <stdint.h>
 
 #include "areas.h"
 #include "ihx_file.h"
+#include "banks.h"
+#include "map_file.h"
+#include "rom_file.h"
+#include "context.h"
 
 // Example data to parse from a .ihx file
 // No area names
@@ -33,19 +36,23 @@
 :00000001FF (EOF indicator)
 */
 
-/* TODO/WARNING/BUG: 100% full banks
-It may not be possible to easily tell the difference between a perfectly filled
-bank (100% and no more) and an adjacent partially filled bank that starts at
+/* 100% full banks
+From the .ihx alone it isn't possible to tell the difference between a perfectly
+filled bank (100% and no more) and an adjacent partially filled bank that starts at
 zero - versus - the first bank overflowed into the second that is empty.
 
-Currently the 100% bank will get merged into the next one and present as overflow
+Without a map the 100% bank presents as overflow. When the linker .map/.noi is
+loaded (-m) the areas from it decide instead: a record crossing a bank boundary
+is accepted if the bytes on each side belong to different areas that each fit
+in their own bank, and only areas which really run past the end of their bank
+are reported.
 */
 
 
 #define BANK_NUM(addr)  ((addr & 0xFFFFC000U) >> 14)
 #define ADDR_UNSET      0xFFFFFFFEU
 
-#define MAX_STR_LEN     4096
+#define READ_BUF_LEN     (1024U * 1024U) // Input is read in large blocks and split into lines in place
 #define IHX_DATA_LEN_MAX 255
 #define IHX_REC_LEN_MIN  (1 + 2 + 4 + 2 + 0 + 2) // Start(1), ByteCount(2), Addr(4), Rec(2), Data(0..255x2), Checksum(2)
 
@@ -57,33 +64,52 @@ Currently the 100% bank will get merged into the next one and present as overflo
 #define IHX_REC_EXTLIN   0x04U
 #define IHX_REC_STARTLIN 0x05U
 
+// Hex digit values, anything that isn't a hex digit has HEX_INVALID set
+// so that OR-ing together every digit of a record flags a bad one
+#define HEX_INVALID      0x80U
+
 typedef struct ihx_record {
-    uint16_t length;
+    uint32_t length;
     uint32_t byte_count;
     uint32_t address;
     uint32_t address_end;
     uint32_t type;
-    uint32_t checksum; // Would prefer this be a uint8_t, but mingw sscanf("%2hhx") has a buffer overflow that corrupts adjacent data
+    uint32_t checksum;
+    uint8_t  data[IHX_DATA_LEN_MAX];
 } ihx_record;
 
-uint32_t g_address_upper;
-bool     g_option_warnings_as_errors = false;
+void set_option_warnings_as_errors(ihx_context * ctx, bool new_val) {
+    ctx->option_warnings_as_errors = new_val;
+}
+
+void set_option_report(ihx_context * ctx, int new_val) {
+    ctx->option_report = new_val;
+}
+
+
+static uint8_t hex_table[256];
+
+
+// Must be called once before any file is processed
+void ihx_file_init(void) {
+
+    int c;
 
-void set_option_warnings_as_errors(bool new_val) {
-    g_option_warnings_as_errors = new_val;
+    for (c = 0; c < 256; c++)
+        hex_table[c] = HEX_INVALID;
+    for (c = 0; c < 10; c++)
+        hex_table['0' + c] = c;
+    for (c = 0; c < 6; c++) {
+        hex_table['A' + c] = 10 + c;
+        hex_table['a' + c] = 10 + c;
+    }
 }
 
 
 // Return false if any character isn't a valid hex digit
-int check_hex(char * c) {
+static int check_hex(char * c) {
     while (*c != '\0') {
-        if ((*c >= '0') && (*c <= '9'))
-            c++;
-        if ((*c >= 'A') && (*c <= 'F'))
-            c++;
-        if ((*c >= 'a') && (*c <= 'f'))
-            c++;
-        else
+        if (hex_table[(uint8_t)*c++] & HEX_INVALID)
             return false;
     }
 
@@ -91,90 +117,105 @@ int check_hex(char * c) {
 }
 
 
+// Decode two hex chars into a byte, OR-ing the digit values into p_bad
+static inline uint32_t hex_byte(const char * p_str, uint8_t * p_bad) {
+
+    uint8_t hi = hex_table[(uint8_t)p_str[0]];
+    uint8_t lo = hex_table[(uint8_t)p_str[1]];
+
+    *p_bad |= hi | lo;
+    return ((hi << 4) | lo) & 0xFFU;
+}
+
+
 // Parse and validate an IHX record
-int ihx_parse_and_validate_record(char * p_str, ihx_record * p_rec) {
-
-        int calc_length = 0;
-        int c;
-        uint32_t ctemp, checksum_calc = 0; // Avoid mingw sscanf("%2hhx") buffer overflow with uint8_t
-
-        // Remove trailing CR and LF
-        p_rec->length = strlen(p_str);
-        for (c = 0;c < p_rec->length;c++) {
-            if (p_str[c] == '\n' || p_str[c] == '\r') {
-                p_str[c] = '\0';   // Replace char with string terminator
-                p_rec->length = c; // Shrink length to truncated size
-                break;             // Exit loop after finding first CR or LF
-            }
-        }
+// p_str is the \0 terminated line (without CR/LF) of length
+//
+// Decoding, hex validation and the checksum are done in a single
+// pass over the record using a lookup table instead of sscanf()
+int ihx_parse_and_validate_record(ihx_context * ctx, char * p_str, uint32_t length, ihx_record * p_rec) {
+
+        uint32_t calc_length;
+        uint32_t c;
+        uint32_t checksum_calc;
+        uint8_t  bad = 0;
+        const char * p_hex;
+
+        p_rec->length = length;
 
         // Only parse lines that start with ':' character (Start token for IHX record)
         if (p_str[0] != ':') {
-            printf("Warning: IHX: Invalid start of line token for line: %s \n", p_str);
+            context_printf(ctx, "Warning: IHX: Invalid start of line token for line: %s \n", p_str);
             return false;
         }
 
        // Require minimum length
         if (p_rec->length < IHX_REC_LEN_MIN) {
-            printf("Warning: IHX: Invalid line, too few characters: %s. Is %d, needs at least %d \n", p_str, p_rec->length, IHX_REC_LEN_MIN);
-            return false;
-        }
-
-        // Only hex characters are allowed after start token
-        p_str++; // Advance past Start code
-        if (check_hex(p_str)) {
-            printf("Warning: IHX: Invalid line, non-hex characters present: %s\n", p_str);
+            context_printf(ctx, "Warning: IHX: Invalid line, too few characters: %s. Is %d, needs at least %d \n", p_str, p_rec->length, IHX_REC_LEN_MIN);
             return false;
         }
 
         // Read record header: byte count, start address, type
-        sscanf(p_str, "%2x%4x%2x", &p_rec->byte_count, &p_rec->address, &p_rec->type);
-        p_str += (2 + 4 + 2);
-
-        // Apply extended linear address (upper 16 bits of address space)
-        // Calculate end address
-        p_rec->address |= g_address_upper;
-        p_rec->address_end = p_rec->address + p_rec->byte_count - 1;
-
+        p_hex = p_str + 1; // Advance past Start code
+        p_rec->byte_count = hex_byte(p_hex, &bad);
+        p_rec->address    = hex_byte(p_hex + 2, &bad) << 8;
+        p_rec->address   |= hex_byte(p_hex + 4, &bad);
+        p_rec->type       = hex_byte(p_hex + 6, &bad);
+        p_hex += (2 + 4 + 2);
 
         // Require expected data byte count to fit within record length (at 2 chars per hex byte)
         calc_length = IHX_REC_LEN_MIN + (p_rec->byte_count * 2);
         if (p_rec->length != calc_length) {
-            printf("Warning: IHX: byte count doesn't match length available in record! Record length = %d, Calc length = %d, bytecount = %d \n", p_rec->length, calc_length, p_rec->byte_count);
+            // Only hex characters are allowed after start token
+            if ((bad & HEX_INVALID) || !check_hex(p_str + 1))
+                context_printf(ctx, "Warning: IHX: Invalid line, non-hex characters present: %s\n", p_str + 1);
+            else
+                context_printf(ctx, "Warning: IHX: byte count doesn't match length available in record! Record length = %d, Calc length = %d, bytecount = %d \n", p_rec->length, calc_length, p_rec->byte_count);
             return false;
         }
 
-        // Is this an extended linear address record? Read in offset address if so
-        if (p_rec->type == IHX_REC_EXTLIN) {
-            sscanf(p_str, "%4x", &g_address_upper);
-            g_address_upper <<= 16; // Shift into upper 16 bits of address space
+        // Apply extended linear address (upper 16 bits of address space)
+        // Calculate end address
+        checksum_calc = p_rec->byte_count + (p_rec->address & 0xFF) + ((p_rec->address >> 8) & 0xFF) + p_rec->type;
+        p_rec->address |= ctx->address_upper;
+        p_rec->address_end = p_rec->address + p_rec->byte_count - 1;
+
+        // Read data segment and calculate checksum of data + headers
+        for (c = 0; c < p_rec->byte_count; c++) {
+            p_rec->data[c] = hex_byte(p_hex, &bad);
+            checksum_calc += p_rec->data[c];
+            p_hex += 2;
         }
 
-        // Read data segment and calculate checsum of data + headers
-        checksum_calc = p_rec->byte_count + (p_rec->address & 0xFF) + ((p_rec->address >> 8) & 0xFF) + p_rec->type;
-        for (c = 0;c < p_rec->byte_count;c++) {
-            sscanf(p_str, "%2x", &ctemp);
-            p_str += 2;
-            checksum_calc += ctemp;
+        // Read checksum from data
+        p_rec->checksum = hex_byte(p_hex, &bad);
+
+        // Only hex characters are allowed after start token
+        if (bad & HEX_INVALID) {
+            context_printf(ctx, "Warning: IHX: Invalid line, non-hex characters present: %s\n", p_str + 1);
+            return false;
         }
 
         // Final calculated checeksum is 2's complement of LSByte
         checksum_calc = (((checksum_calc & 0xFF) ^ 0xFF) + 1) & 0xFF;
 
-        // Read checksum from data
-        sscanf(p_str, "%2x", &p_rec->checksum);
-        p_str += 2;
-
         if (p_rec->checksum != checksum_calc) {
-            printf("Warning: IHX: record checksum %x didn't match calculated checksum %x\n", p_rec->checksum, checksum_calc);
+            context_printf(ctx, "Warning: IHX: record checksum %x didn't match calculated checksum %x\n", p_rec->checksum, checksum_calc);
             return false;
         }
 
+        // Is this an extended linear address record? Read in offset address if so
+        if (p_rec->type == IHX_REC_EXTLIN) {
+            ctx->address_upper = (hex_byte(p_str + 9, &bad) << 8) | hex_byte(p_str + 11, &bad);
+            ctx->address_upper <<= 16; // Shift into upper 16 bits of address space
+        }
+
         // For records that start in banks above the unbanked region (0x000 - 0x3FFF)
         // Warn (but don't error) if they cross the boundary between different banks
         if ((p_rec->address >= 0x00004000U) &&
-            ((p_rec->address & 0xFFFFC000U) != (p_rec->address_end & 0xFFFFC000U))) {
-            printf("Warning: Write from one bank spans into the next. %x -> %x (bank %d -> %d)\n",
+            ((p_rec->address & 0xFFFFC000U) != (p_rec->address_end & 0xFFFFC000U)) &&
+            !(map_file_loaded(ctx) && map_span_is_split_area(ctx, p_rec->address, p_rec->address_end))) {
+            context_printf(ctx, "Warning: Write from one bank spans into the next. %x -> %x (bank %d -> %d)\n",
                    p_rec->address, p_rec->address_end, BANK_NUM(p_rec->address), BANK_NUM(p_rec->address_end));
         }
 
@@ -182,19 +223,74 @@ int ihx_parse_and_validate_record(char * p_str, ihx_record * p_rec) {
 }
 
 
-int ihx_file_process_areas(char * filename_in) {
+// Validate one line of the .ihx and merge it into the pending area
+static void ihx_process_line(ihx_context * ctx, char * p_line, uint32_t length, area_item * p_area) {
 
-    int  ret = EXIT_SUCCESS; // default to success
-    char cols;
-    char strline_in[MAX_STR_LEN] = "";
-    FILE * ihx_file = fopen(filename_in, "r");
-    area_item area;
     ihx_record ihx_rec;
 
-    areas_init();
+    // Parse record, skip if fails validation
+    if (!ihx_parse_and_validate_record(ctx, p_line, length, &ihx_rec))
+        return;
+
+    // Process the pending record and exit if last record (EOF)
+    // Also ignore non-default data records (don't seem to occur for gbz80)
+    if (ihx_rec.type == IHX_REC_EOF) {
+        if (p_area->start != ADDR_UNSET)
+            areas_add(ctx, p_area);
+        return;
+    } else if (ihx_rec.type == IHX_REC_EXTLIN) {
+        // printf("Extended linear address changed to %08x %s\n\n\n", ctx->address_upper, p_line);
+        return;
+    } else if (ihx_rec.type != IHX_REC_DATA) {
+        context_printf(ctx, "Warning: IHX: dropped record %s of type %d\n", p_line, ihx_rec.type);
+        return;
+    }
+
+    // Copy the data straight into the ROM image if one is being written
+    if (ctx->rom.data)
+        rom_write(ctx, ihx_rec.address, ihx_rec.data, ihx_rec.byte_count);
+
+    // Records are left pending (non-processed) until they don't merge
+    // with the current incoming record *or* the final (EOF) record is found.
+
+    // Try to merge with (pending) previous record if it's address-adjacent,
+    // except when the new record starts or ends on a bank boundary
+    // (this reduces count from 1000's since most are only 32 bytes long)
+    if ((ihx_rec.address == p_area->end + 1) && ((ihx_rec.address & 0x00003FFFU) != 0x00000000U)) {
+        p_area->end = ihx_rec.address_end;  // append to previous area
+    } else if ((ihx_rec.address_end == p_area->start + 1) && !((ihx_rec.address_end & 0x00003FFFU) != 0x00003FFFU)) {
+        p_area->start = ihx_rec.address;    // pre-pend to previous area
+    } else {
+        // New record was *not* adjacent to last,
+        // so process the last/pending record
+        if (p_area->start != ADDR_UNSET)
+            areas_add(ctx, p_area);
+        // Now queue current record as pending for next loop
+        p_area->start = ihx_rec.address;
+        p_area->end   = ihx_rec.address + ihx_rec.byte_count - 1;
+    }
+}
+
+
+int ihx_file_process_areas(ihx_context * ctx, char * filename_in) {
+
+    int  ret = EXIT_SUCCESS; // default to success
+    FILE * ihx_file = fopen(filename_in, "rb");
+    area_item area;
+    char * buf;
+    char * p_line;
+    char * p_end;
+    char * p_buf_end;
+    size_t buf_used = 0;
+    size_t bytes_read;
+    uint32_t length;
+
+    areas_init(ctx);
+    if (ctx->rom_filename || ctx->rom_in_memory)
+        rom_init(ctx);
 
     // Initialize global upper address modifier
-    g_address_upper = 0x0000;
+    ctx->address_upper = 0x0000;
 
     // Initialize area record
     area.start = ADDR_UNSET;
@@ -203,60 +299,71 @@ int ihx_file_process_areas(char * filename_in) {
 
     if (ihx_file) {
 
-        // Read one line at a time into \0 terminated string
-        while (fgets(strline_in, sizeof(strline_in), ihx_file) != NULL) {
-
-            // Parse record, skip if fails validation
-            if (!ihx_parse_and_validate_record(strline_in, &ihx_rec))
-                continue;
-
-            // Process the pending record and exit if last record (EOF)
-            // Also ignore non-default data records (don't seem to occur for gbz80)
-            if (ihx_rec.type == IHX_REC_EOF) {
-                if (!areas_add(&area) && g_option_warnings_as_errors)
-                    ret = EXIT_FAILURE;
-                continue;
-            } else if (ihx_rec.type == IHX_REC_EXTLIN) {
-                // printf("Extended linear address changed to %08x %s\n\n\n", g_address_upper, strline_in);
-                continue;
-            } else if (ihx_rec.type != IHX_REC_DATA) {
-                printf("Warning: IHX: dropped record %s of type %d\n", strline_in, ihx_rec.type);
-                continue;
-            }
-
-            // Records are left pending (non-processed) until they don't merge
-            // with the current incoming record *or* the final (EOF) record is found.
-
-            // Try to merge with (pending) previous record if it's address-adjacent,
-            // except when the new record starts or ends on a bank boundary
-            // (this reduces count from 1000's since most are only 32 bytes long)
-            if ((ihx_rec.address == area.end + 1) && ((ihx_rec.address & 0x00003FFFU) != 0x00000000U)) {
-                area.end = ihx_rec.address_end;  // append to previous area
-            } else if ((ihx_rec.address_end == area.start + 1) && !((ihx_rec.address_end & 0x00003FFFU) != 0x00003FFFU)) {
-                area.start = ihx_rec.address;    // pre-pend to previous area
-            } else {
-                // New record was *not* adjacent to last,
-                // so process the last/pending record
-                if (area.start != ADDR_UNSET) {
-                    if (!areas_add(&area) && g_option_warnings_as_errors)
-                        ret = EXIT_FAILURE;
+        // Room for a \0 after the last line in the buffer
+        buf = (char *)malloc(READ_BUF_LEN + 1);
+
+        // Read large blocks and process every complete line in them,
+        // carrying a trailing partial line over to the next block
+        do {
+            bytes_read = fread(buf + buf_used, 1, READ_BUF_LEN - buf_used, ihx_file);
+            buf_used += bytes_read;
+            p_buf_end = buf + buf_used;
+
+            for (p_line = buf; p_line < p_buf_end; p_line = p_end + 1) {
+
+                p_end = (char *)memchr(p_line, '\n', p_buf_end - p_line);
+                if (p_end == NULL) {
+                    // Wait for the rest of the line unless at the end of the
+                    // file or the line alone fills the buffer (invalid anyway)
+                    if ((bytes_read != 0) && (p_line != buf))
+                        break;
+                    p_end = p_buf_end;
                 }
-                // Now queue current record as pending for next loop
-                area.start = ihx_rec.address;
-                area.end   = ihx_rec.address + ihx_rec.byte_count - 1;
+
+                // Replace LF (and CR before it) with string terminator
+                *p_end = '\0';
+                length = p_end - p_line;
+                if ((length > 0) && (p_line[length - 1] == '\r'))
+                    p_line[--length] = '\0';
+
+                ihx_process_line(ctx, p_line, length, &area);
             }
 
-        } // end: while still lines to process
+            // Move any partial line to the start of the buffer
+            buf_used = (p_line < p_buf_end) ? (p_buf_end - p_line) : 0;
+            if (buf_used)
+                memmove(buf, p_line, buf_used);
+
+        } while (bytes_read != 0);
 
+        free(buf);
         fclose(ihx_file);
 
+        if (!ctx->option_no_checks) {
+            // Warn about all overlapping areas now that every area is known
+            if (!areas_check_overlaps(ctx) && ctx->option_warnings_as_errors)
+                ret = EXIT_FAILURE;
+
+            // Areas from the linker map which run past the end of their bank
+            if (map_file_loaded(ctx) && !map_areas_check_banks(ctx) && ctx->option_warnings_as_errors)
+                ret = EXIT_FAILURE;
+        }
+
+        if (ctx->option_report != REPORT_NONE)
+            banks_report(ctx, ctx->option_report);
+
+        // Only write the ROM if the checks passed
+        if (ctx->rom_filename && (ret == EXIT_SUCCESS) && !rom_file_write(ctx, ctx->rom_filename))
+            ret = EXIT_FAILURE;
+        else if (ctx->rom_in_memory && (ret == EXIT_SUCCESS))
+            rom_finalize(ctx);
+
     } // end: if valid file
     else {
-        printf("Problem with filename or unable to open file! %s\n", filename_in);
+        context_printf(ctx, "Problem with filename or unable to open file! %s\n", filename_in);
         ret = EXIT_FAILURE;
     }
 
-    areas_cleanup();
+    areas_cleanup(ctx);
     return ret;
 }
-
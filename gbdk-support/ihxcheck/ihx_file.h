@@ -6,7 +6,11 @@
 #ifndef _IHX_FILE_H
 #define _IHX_FILE_H
 
-int ihx_file_process_areas(char * filename_in);
-void set_option_warnings_as_errors(bool new_val);
+struct ihx_context;
+
+void ihx_file_init(void);
+int ihx_file_process_areas(struct ihx_context * ctx, char * filename_in);
+void set_option_warnings_as_errors(struct ihx_context * ctx, bool new_val);
+void set_option_report(struct ihx_context * ctx, int new_val);
 
 #endif // _IHX_FILE_H
\ No newline at end of file
@@ -5,35 +5,103 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <unistd.h>
 #include <stdbool.h>
 #include <stdint.h>
 
 #include "ihx_file.h"
 #include "areas.h"
+#include "banks.h"
+#include "map_file.h"
+#include "rom_file.h"
+#include "context.h"
+#include "batch.h"
 
 #define MAX_STR_LEN     4096
+#define FILES_GROW_SIZE 100
 
 void display_help(void);
 int handle_args(int argc, char * argv[]);
+int map_file_open(ihx_context * ctx, char * filename_ihx);
+int ihxcheck_main(int argc, char * argv[]);
 
-char filename_in[MAX_STR_LEN] = {'\0'};
+// Options are set on this context and copied to the one for each file
+ihx_context options;
+
+char **   filenames = NULL;
+uint32_t  filenames_count;
+uint32_t  filenames_size;
+uint32_t  option_jobs;
+char filename_map[MAX_STR_LEN] = {'\0'};
+bool option_map = false;
 
 
 void display_help(void) {
     fprintf(stdout,
-           "ihx_check input_file.ihx [options]\n"
+           "ihx_check input_file.ihx [more_files.ihx ...] [options]\n"
            "\n"
            "Options\n"
            "-h : Show this help\n"
            "-e : Treat warnings as errors\n"
+           "-r : Show used and free space for each ROM bank\n"
+           "-rj: Same as -r, formatted as JSON\n"
+           "-m : Use the linker .map (or .noi) next to the .ihx to check banks\n"
+           "-m<file> : Same as -m with a given .map or .noi file (single input only)\n"
+           "     Lets banks filled to exactly 100%% pass without warnings\n"
+           "-j <n> : Check up to n files at the same time (default: number of CPUs)\n"
+           "-o <file.gb> : Also write the ROM image, same as makebin -Z (single input only)\n"
+           "     Header options: -yo <n|A> ROM banks, -ya <n> RAM banks, -yt <n> cart type,\n"
+           "     -yn <name> title, -yc CGB, -yC CGB only, -ys SGB, -yj non-Japanese,\n"
+           "     -yk <cc> licensee, -yl <hh> old licensee, -yp <addr=value> patch byte\n"
+           "-n : Skip the checks, only write the ROM\n"
+           "@<file> : Read more input filenames from <file>, one per line\n"
            "\n"
            "Use: Read a .ihx and warn about overlapped areas.\n"
+           "     Optionally report how full each ROM bank is.\n"
+           "     With more than one file, each is checked on its own and\n"
+           "     a summary is printed. Fails if any file fails.\n"
            "Example: \"ihx_check build/MyProject.ihx\"\n"
+           "Example: \"ihx_check -j 8 -e build/*.ihx\"\n"
+           "Example: \"ihx_check build/MyProject.ihx -o build/MyProject.gb -yt 0x1B -yo A\"\n"
            );
 }
 
 
+static void filenames_add(char * filename) {
+
+    // Grow array if needed
+    if (filenames_count == filenames_size) {
+        filenames_size += FILES_GROW_SIZE;
+        filenames = (char **)realloc(filenames, filenames_size * sizeof(char *));
+    }
+
+    filenames[filenames_count++] = filename;
+}
+
+
+// Add every line of a file list as an input filename
+static int filenames_add_list(char * filename_list) {
+
+    char strline_in[MAX_STR_LEN];
+    size_t len;
+    FILE * list_file = fopen(filename_list, "r");
+
+    if (!list_file) {
+        printf("Problem with filename or unable to open file! %s\n", filename_list);
+        return false;
+    }
+
+    while (fgets(strline_in, sizeof(strline_in), list_file) != NULL) {
+        // Remove trailing CR and LF, skip empty lines
+        len = strcspn(strline_in, "\r\n");
+        strline_in[len] = '\0';
+        if (len > 0)
+            filenames_add(strdup(strline_in));
+    }
+    fclose(list_file);
+    return true;
+}
+
+
 int handle_args(int argc, char * argv[]) {
 
     int i;
@@ -43,22 +111,62 @@ int handle_args(int argc, char * argv[]) {
         return false;
     }
 
-    // Copy input filename (if not preceded with option dash)
-    if (argv[1][0] != '-')
-        snprintf(filename_in, sizeof(filename_in), "%s", argv[1]);
-
     // Start at first optional argument, argc is zero based
     for (i = 1; i <= (argc -1); i++ ) {
 
-        if (strstr(argv[i], "-h")) {
+        // Anything not preceded with an option dash is an input file
+        if (argv[i][0] == '@') {
+            if (!filenames_add_list(argv[i] + 1))
+                return false;
+        } else if (argv[i][0] != '-') {
+            filenames_add(argv[i]);
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            // -j <n>, -j<n> or -j alone for the number of CPUs
+            if (argv[i][2] != '\0')
+                option_jobs = atoi(argv[i] + 2);
+            else if ((i + 1 < argc) && (argv[i + 1][0] >= '0') && (argv[i + 1][0] <= '9'))
+                option_jobs = atoi(argv[++i]);
+            else
+                option_jobs = batch_cpu_count();
+        } else if (strncmp(argv[i], "-o", 2) == 0) {
+            // -o <file> or -o<file>
+            if (argv[i][2] != '\0')
+                options.rom_filename = argv[i] + 2;
+            else if (i + 1 < argc)
+                options.rom_filename = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0) {
+            options.option_no_checks = true;
+        } else if (argv[i][1] == 'y') {
+            if (!rom_option(&options, argc, argv, &i)) {
+                printf("Error: unknown ROM option %s\n", argv[i]);
+                return false;
+            }
+        } else if (strncmp(argv[i], "-m", 2) == 0) {
+            option_map = true;
+            snprintf(filename_map, sizeof(filename_map), "%s", argv[i] + 2);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            set_option_report(&options, REPORT_TEXT);
+        } else if (strcmp(argv[i], "-rj") == 0) {
+            set_option_report(&options, REPORT_JSON);
+        } else if (strstr(argv[i], "-h")) {
             display_help();
             return false;  // Don't parse input when -h is used
         } else if (strstr(argv[i], "-e")) {
-            set_option_warnings_as_errors(true);
+            set_option_warnings_as_errors(&options, true);
         }
 
     }
 
+    if ((filenames_count > 1) && (filename_map[0] != '\0')) {
+        printf("Error: -m<file> can only be used with a single input file, use -m instead\n");
+        return false;
+    }
+
+    if ((filenames_count > 1) && options.rom_filename) {
+        printf("Error: -o can only be used with a single input file\n");
+        return false;
+    }
+
     return true;
 }
 
@@ -68,20 +176,111 @@ int matches_extension(char * filename, char * extension) {
 }
 
 
-int main( int argc, char *argv[] )  {
+// Load the map given with -m, or the .map/.noi with the same name as the .ihx
+int map_file_open(ihx_context * ctx, char * filename_ihx) {
 
-    int ret = EXIT_FAILURE; // Exit with failure by default
+    FILE * test_file;
+    char filename[MAX_STR_LEN];
+    size_t base_len = strlen(filename_ihx) - strlen(".ihx");
 
-    if (handle_args(argc, argv)) {
+    if (filename_map[0] != '\0')
+        return map_file_load(ctx, filename_map);
 
-        // Must at least have extension
-        if (strlen(filename_in) >=5) {
-            // detect file extension
-            if (matches_extension(filename_in, (char *)".ihx")) {
-                ret = ihx_file_process_areas(filename_in);
-            }
+    snprintf(filename, sizeof(filename), "%.*s.map", (int)base_len, filename_ihx);
+    if ((test_file = fopen(filename, "r")) != NULL)
+        fclose(test_file);
+    else
+        snprintf(filename, sizeof(filename), "%.*s.noi", (int)base_len, filename_ihx);
+
+    return map_file_load(ctx, filename);
+}
+
+
+// Check one file, only uses the job's own context
+// so it can run on any thread
+static void check_file(batch_job * p_job) {
+
+    p_job->ret = EXIT_FAILURE; // Exit with failure by default
+
+    // Must at least have extension
+    if (strlen(p_job->filename) >=5) {
+        // detect file extension
+        if (matches_extension(p_job->filename, (char *)".ihx")) {
+            if (option_map && !map_file_open(&p_job->ctx, p_job->filename))
+                return;
+            p_job->ret = ihx_file_process_areas(&p_job->ctx, p_job->filename);
+            map_file_cleanup(&p_job->ctx);
+            return;
+        }
+    }
+
+    if (filenames_count > 1)
+        context_printf(&p_job->ctx, "Not a .ihx file! %s\n", p_job->filename);
+}
+
+
+// Check all input files, in parallel with -j, and print a summary
+static int check_files(void) {
+
+    uint32_t c;
+    uint32_t failed = 0;
+    bool batch = (filenames_count > 1);
+    batch_job * jobs = (batch_job *)calloc(filenames_count, sizeof(batch_job));
+
+    for (c = 0; c < filenames_count; c++) {
+        jobs[c].filename = filenames[c];
+        jobs[c].ctx = options;
+        // Keep output from each file together, in input order
+        jobs[c].ctx.out_buffered = batch;
+    }
+
+    batch_run(jobs, filenames_count, (option_jobs > 0) ? option_jobs : 1, check_file);
+
+    for (c = 0; c < filenames_count; c++) {
+        if (batch) {
+            printf("%s: %s\n", jobs[c].filename, (jobs[c].ret == EXIT_SUCCESS) ? "OK" : "FAILED");
+            context_flush(&jobs[c].ctx);
         }
+        if (jobs[c].ret != EXIT_SUCCESS)
+            failed++;
+        context_cleanup(&jobs[c].ctx);
     }
 
+    if (batch) {
+        printf("\nChecked %d files: %d passed, %d failed\n", filenames_count, filenames_count - failed, failed);
+        for (c = 0; c < filenames_count; c++)
+            if (jobs[c].ret != EXIT_SUCCESS)
+                printf("FAILED: %s\n", jobs[c].filename);
+    }
+
+    free(jobs);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+// Also called directly by lcc, which links ihxcheck in
+// instead of running it as a separate process
+int ihxcheck_main( int argc, char *argv[] )  {
+
+    int ret = EXIT_FAILURE; // Exit with failure by default
+
+    context_init(&options);
+    filenames_count = 0;
+    option_jobs = 0;
+    filename_map[0] = '\0';
+    option_map = false;
+    ihx_file_init();
+
+    if (handle_args(argc, argv)) {
+        if (filenames_count > 0)
+            ret = check_files();
+    }
+
+    // Names from a file list are not freed, they live until exit
+    if (filenames)
+        free(filenames);
+    filenames = NULL;
+    filenames_size = 0;
+
     return ret; // Exit with failure by default
-}
\ No newline at end of file
+}
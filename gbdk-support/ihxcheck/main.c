@@ -0,0 +1,9 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+int ihxcheck_main(int argc, char * argv[]);
+
+int main( int argc, char *argv[] )  {
+    return ihxcheck_main(argc, argv);
+}
@@ -0,0 +1,239 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "areas.h"
+#include "banks.h"
+#include "map_file.h"
+#include "context.h"
+
+// Reads the area list from the linker output so that bytes in the .ihx
+// can be attributed to the area (and bank) they were linked for.
+//
+// .map (sdldgb -m), one line per area:
+// _CODE_1                             00014000    00000123 =         291. bytes (REL,CON)
+//
+// .noi (sdldgb -j), start and length symbols per area:
+// DEF s__CODE_1 0x14000
+// DEF l__CODE_1 0x123
+//
+// Banked areas use the linker's bank addressing (bank in the upper
+// 16 bits, 0x4000 - 0x7FFF in the lower), the .ihx uses linear ROM
+// addresses (bank * 0x4000), so addresses get converted.
+
+#define MAX_STR_LEN     4096
+#define AREA_GROW_SIZE  100
+
+#define MAP_ADDR_UNSET  0xFFFFFFFFU
+
+// Convert a linker (bank << 16 | address) to a linear ROM address
+static uint32_t map_addr_to_linear(uint32_t addr) {
+
+    if (addr > 0xFFFFU)
+        return ((addr >> 16) * BANK_SIZE) + (addr & (BANK_SIZE - 1));
+    else
+        return addr;
+}
+
+
+// Find an area by name, add it if it isn't there yet
+static map_area * map_area_get(ihx_context * ctx, char * name) {
+
+    uint32_t c;
+
+    for (c = 0; c < ctx->maplist_count; c++)
+        if (strcmp(ctx->maplist[c].name, name) == 0)
+            return &ctx->maplist[c];
+
+    // Grow array if needed
+    if (ctx->maplist_count == ctx->maplist_size) {
+        ctx->maplist_size += AREA_GROW_SIZE;
+        ctx->maplist = (map_area *)realloc(ctx->maplist, ctx->maplist_size * sizeof(map_area));
+    }
+
+    snprintf(ctx->maplist[ctx->maplist_count].name, MAP_NAME_LEN, "%s", name);
+    ctx->maplist[ctx->maplist_count].start = MAP_ADDR_UNSET;
+    ctx->maplist[ctx->maplist_count].end   = MAP_ADDR_UNSET;
+    return &ctx->maplist[ctx->maplist_count++];
+}
+
+
+static int map_area_cmp_start(const void * a, const void * b) {
+
+    const map_area * p_a = (const map_area *)a;
+    const map_area * p_b = (const map_area *)b;
+
+    return (p_a->start > p_b->start) - (p_a->start < p_b->start);
+}
+
+
+// Keep only ROM areas with a size, sorted by start address
+static void map_areas_finalize(ihx_context * ctx, uint32_t * lengths) {
+
+    uint32_t c, n = 0;
+
+    for (c = 0; c < ctx->maplist_count; c++) {
+        // Areas in RAM (0x8000 and up in the CPU address space) aren't in the ROM
+        if ((ctx->maplist[c].start == MAP_ADDR_UNSET) || (lengths[c] == 0) ||
+            ((ctx->maplist[c].start & 0xFFFFU) >= 0x8000U))
+            continue;
+        ctx->maplist[n].start = map_addr_to_linear(ctx->maplist[c].start);
+        ctx->maplist[n].end   = ctx->maplist[n].start + lengths[c] - 1;
+        memcpy(ctx->maplist[n].name, ctx->maplist[c].name, MAP_NAME_LEN);
+        n++;
+    }
+    ctx->maplist_count = n;
+    qsort(ctx->maplist, ctx->maplist_count, sizeof(map_area), map_area_cmp_start);
+}
+
+
+int map_file_load(ihx_context * ctx, char * filename_in) {
+
+    char strline_in[MAX_STR_LEN] = "";
+    char name[MAX_STR_LEN];
+    uint32_t addr, length;
+    uint32_t * lengths = NULL;
+    uint32_t lengths_size = 0;
+    map_area * p_area;
+    bool is_noi = (strlen(filename_in) >= 4) &&
+                  (strcmp(filename_in + strlen(filename_in) - 4, ".noi") == 0);
+    FILE * map_file = fopen(filename_in, "r");
+
+    map_file_cleanup(ctx);
+
+    if (!map_file) {
+        context_printf(ctx, "Problem with filename or unable to open file! %s\n", filename_in);
+        return false;
+    }
+
+    while (fgets(strline_in, sizeof(strline_in), map_file) != NULL) {
+
+        // .noi: "DEF s__AREA 0x1234" and "DEF l__AREA 0x1234"
+        // .map: "_AREA   00001234    00000123 =  291. bytes (REL,CON)"
+        if (is_noi) {
+            if ((sscanf(strline_in, "DEF %s %x", name, &addr) != 2) ||
+                (strlen(name) < 4) || (name[1] != '_') || (name[2] != '_') ||
+                ((name[0] != 's') && (name[0] != 'l')))
+                continue;
+            p_area = map_area_get(ctx, name + 2);
+        } else {
+            if (sscanf(strline_in, "%s %x %x = %u. bytes", name, &addr, &length, &length) != 4)
+                continue;
+            p_area = map_area_get(ctx, name);
+        }
+
+        // Lengths are kept apart until the start is known
+        if (ctx->maplist_size > lengths_size) {
+            lengths = (uint32_t *)realloc(lengths, ctx->maplist_size * sizeof(uint32_t));
+            memset(lengths + lengths_size, 0, (ctx->maplist_size - lengths_size) * sizeof(uint32_t));
+            lengths_size = ctx->maplist_size;
+        }
+
+        if (is_noi && (name[0] == 'l'))
+            lengths[p_area - ctx->maplist] = addr;
+        else {
+            p_area->start = addr;
+            if (!is_noi)
+                lengths[p_area - ctx->maplist] = length;
+        }
+    }
+    fclose(map_file);
+
+    map_areas_finalize(ctx, lengths);
+    if (lengths)
+        free(lengths);
+
+    if (ctx->maplist_count == 0) {
+        context_printf(ctx, "Warning: no ROM areas found in %s\n", filename_in);
+        map_file_cleanup(ctx);
+        return false;
+    }
+
+    return true;
+}
+
+
+void map_file_cleanup(ihx_context * ctx) {
+    if (ctx->maplist)
+        free(ctx->maplist);
+    ctx->maplist = NULL;
+    ctx->maplist_size = 0;
+    ctx->maplist_count = 0;
+}
+
+
+bool map_file_loaded(ihx_context * ctx) {
+    return (ctx->maplist_count > 0);
+}
+
+
+// Returns index of the area containing addr, or -1 if none
+static int32_t map_area_find(ihx_context * ctx, uint32_t addr) {
+
+    int32_t lo = 0, hi = (int32_t)ctx->maplist_count - 1, mid;
+
+    // Last area starting at or before addr
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (ctx->maplist[mid].start <= addr)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    if ((hi >= 0) && (addr <= ctx->maplist[hi].end))
+        return hi;
+    return -1;
+}
+
+
+static bool map_area_in_one_bank(map_area * p_area) {
+    return (p_area->start / BANK_SIZE) == (p_area->end / BANK_SIZE);
+}
+
+
+// A record that crosses a bank boundary is fine if the bytes on each
+// side of it belong to different areas that each fit in their bank,
+// such as a 100% full bank followed directly by the next one
+bool map_span_is_split_area(ihx_context * ctx, uint32_t addr_start, uint32_t addr_end) {
+
+    uint32_t boundary;
+    int32_t  before, after;
+
+    for (boundary = (addr_start / BANK_SIZE + 1) * BANK_SIZE; boundary <= addr_end; boundary += BANK_SIZE) {
+        before = map_area_find(ctx, boundary - 1);
+        after  = map_area_find(ctx, boundary);
+        if ((before < 0) || (after < 0) || (before == after) ||
+            !map_area_in_one_bank(&ctx->maplist[before]) || !map_area_in_one_bank(&ctx->maplist[after]))
+            return false;
+    }
+    return true;
+}
+
+
+// Warn about banked areas that don't fit in their bank
+// Returns false if any were found
+int map_areas_check_banks(ihx_context * ctx) {
+
+    uint32_t c;
+    int ret = true;
+
+    for (c = 0; c < ctx->maplist_count; c++) {
+        // Bank 0 areas may continue into 0x4000 - 0x7FFF on unbanked ROMs
+        if (ctx->maplist[c].start < BANK_SIZE)
+            continue;
+        if (!map_area_in_one_bank(&ctx->maplist[c])) {
+            context_printf(ctx, "Warning: Area %s overflows bank %d by %d bytes. %x -> %x\n",
+                   ctx->maplist[c].name, ctx->maplist[c].start / BANK_SIZE,
+                   ctx->maplist[c].end - (((ctx->maplist[c].start / BANK_SIZE) + 1) * BANK_SIZE - 1),
+                   ctx->maplist[c].start, ctx->maplist[c].end);
+            ret = false;
+        }
+    }
+    return ret;
+}
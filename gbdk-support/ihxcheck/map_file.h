@@ -0,0 +1,25 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+#ifndef _MAP_FILE_H
+#define _MAP_FILE_H
+
+#define MAP_NAME_LEN    64
+
+typedef struct map_area {
+    char     name[MAP_NAME_LEN];
+    uint32_t start;     // ROM address, same linear space as the .ihx
+    uint32_t end;
+} map_area;
+
+
+struct ihx_context;
+
+int  map_file_load(struct ihx_context * ctx, char * filename_in);
+void map_file_cleanup(struct ihx_context * ctx);
+bool map_file_loaded(struct ihx_context * ctx);
+int  map_areas_check_banks(struct ihx_context * ctx);
+bool map_span_is_split_area(struct ihx_context * ctx, uint32_t addr_start, uint32_t addr_end);
+
+#endif // _MAP_FILE_H
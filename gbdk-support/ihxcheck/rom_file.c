@@ -0,0 +1,280 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "banks.h"
+#include "rom_file.h"
+#include "context.h"
+
+// Builds the .gb ROM image directly from the .ihx records as they are
+// parsed, instead of running makebin -Z over the .ihx afterward.
+//
+// Unwritten bytes are 0xFF, the image is padded to a power of two and
+// the header fields set by crt0.s are filled in from the options:
+//
+// 0x134 - 0x143 : Title (-yn), 0x143 is also the CGB flag (-yc, -yC)
+// 0x144 - 0x145 : New licensee code (-yk)
+// 0x146         : SGB flag (-ys)
+// 0x147         : Cartridge type (-yt)
+// 0x148         : ROM size, always set from the image size
+// 0x149         : RAM size (-ya)
+// 0x14A         : Destination code (-yj)
+// 0x14B         : Old licensee code (-yl)
+// 0x14D         : Header checksum
+// 0x14E - 0x14F : Global checksum (big endian)
+
+#define HEADER_TITLE        0x134U
+#define HEADER_TITLE_LEN    16U
+#define HEADER_CGB          0x143U
+#define HEADER_LICENSEE     0x144U
+#define HEADER_SGB          0x146U
+#define HEADER_CART_TYPE    0x147U
+#define HEADER_ROM_SIZE     0x148U
+#define HEADER_RAM_SIZE     0x149U
+#define HEADER_DEST         0x14AU
+#define HEADER_OLD_LICENSEE 0x14BU
+#define HEADER_CHECKSUM     0x14DU
+#define HEADER_GLOBAL_SUM   0x14EU
+
+#define OLD_LICENSEE_USE_NEW 0x33U  // Required for SGB support
+#define PATCH_GROW_SIZE     16
+
+
+void rom_options_init(rom_options * p_opts) {
+    memset(p_opts, 0, sizeof(rom_options));
+    p_opts->ram_banks    = ROM_OPT_UNSET;
+    p_opts->cart_type    = ROM_OPT_UNSET;
+    p_opts->cgb          = ROM_OPT_UNSET;
+    p_opts->old_licensee = ROM_OPT_UNSET;
+}
+
+
+// Process one makebin style -y option, which may take its value from the next argument
+// Returns true if the option was recognized
+int rom_option(ihx_context * ctx, int argc, char * argv[], int * p_argn) {
+
+    rom_options * p_opts = &ctx->rom_opts;
+    char * arg = argv[*p_argn];
+    char * value;
+    char * p_sep;
+
+    if ((arg[0] != '-') || (arg[1] != 'y') || (arg[2] == '\0'))
+        return false;
+
+    // Options without a value
+    switch (arg[2]) {
+        case 'c': p_opts->cgb = 0x80; return true;
+        case 'C': p_opts->cgb = 0xC0; return true;
+        case 's': p_opts->sgb = true; return true;
+        case 'j': p_opts->non_japanese = true; return true;
+    }
+
+    // Value is either attached (-yt2) or the next argument (-yt 2)
+    if (arg[3] != '\0')
+        value = arg + 3;
+    else if (*p_argn + 1 < argc)
+        value = argv[++(*p_argn)];
+    else {
+        printf("Error: missing value for %s\n", arg);
+        return false;
+    }
+
+    switch (arg[2]) {
+        case 'o':
+            p_opts->rom_banks = ((value[0] == 'A') || (value[0] == 'a')) ? 0 : strtol(value, NULL, 0);
+            return true;
+        case 'a': p_opts->ram_banks    = strtol(value, NULL, 0); return true;
+        case 't': p_opts->cart_type    = strtol(value, NULL, 0); return true;
+        case 'l': p_opts->old_licensee = strtol(value, NULL, 16); return true;
+        case 'k': snprintf(p_opts->licensee, sizeof(p_opts->licensee), "%s", value); return true;
+        case 'n': snprintf(p_opts->title, sizeof(p_opts->title), "%s", value); return true;
+        case 'p':
+            // -yp addr=value
+            if ((p_sep = strchr(value, '=')) == NULL) {
+                printf("Error: -yp needs addr=value, got %s\n", value);
+                return false;
+            }
+            if ((p_opts->patches_count % PATCH_GROW_SIZE) == 0)
+                p_opts->patches = (rom_patch *)realloc(p_opts->patches,
+                                   (p_opts->patches_count + PATCH_GROW_SIZE) * sizeof(rom_patch));
+            p_opts->patches[p_opts->patches_count].address = strtoul(value, NULL, 0);
+            p_opts->patches[p_opts->patches_count].value   = strtoul(p_sep + 1, NULL, 0);
+            p_opts->patches_count++;
+            return true;
+    }
+
+    return false;
+}
+
+
+// Grow the image (doubling) so that address fits
+static bool rom_grow(rom_image * p_rom, uint32_t address) {
+
+    uint32_t new_size = p_rom->size;
+
+    if (address >= ROM_SIZE_MAX)
+        return false;
+    while (new_size <= address)
+        new_size *= 2;
+    p_rom->data = (uint8_t *)realloc(p_rom->data, new_size);
+    memset(p_rom->data + p_rom->size, ROM_FILL_VALUE, new_size - p_rom->size);
+    p_rom->size = new_size;
+    return true;
+}
+
+
+// Preallocate the image at the size asked for with -yo (or the minimum)
+void rom_init(ihx_context * ctx) {
+
+    rom_image * p_rom = &ctx->rom;
+
+    p_rom->size     = ROM_SIZE_MIN;
+    p_rom->used_end = 0;
+    p_rom->data     = (uint8_t *)malloc(p_rom->size);
+    memset(p_rom->data, ROM_FILL_VALUE, p_rom->size);
+
+    if (ctx->rom_opts.rom_banks > 0)
+        rom_grow(p_rom, ctx->rom_opts.rom_banks * BANK_SIZE - 1);
+}
+
+
+// Copy the data of one record into the image
+void rom_write(ihx_context * ctx, uint32_t address, const uint8_t * p_data, uint32_t length) {
+
+    rom_image * p_rom = &ctx->rom;
+
+    if (length == 0)
+        return;
+
+    if ((address + length > p_rom->size) && !rom_grow(p_rom, address + length - 1)) {
+        context_printf(ctx, "Warning: ROM: write at 0x%x is past the maximum ROM size, dropped\n", address);
+        return;
+    }
+    memcpy(p_rom->data + address, p_data, length);
+
+    if (address + length > p_rom->used_end)
+        p_rom->used_end = address + length;
+}
+
+
+// RAM size header code from number of 8K banks
+static int rom_ram_size_code(ihx_context * ctx, int32_t ram_banks) {
+
+    switch (ram_banks) {
+        case 0:  return 0x00;
+        case 1:  return 0x02;
+        case 4:  return 0x03;
+        case 16: return 0x04;
+        case 8:  return 0x05;
+    }
+    context_printf(ctx, "Warning: ROM: unsupported number of RAM banks %d, RAM size left at 0\n", ram_banks);
+    return 0x00;
+}
+
+
+// Set the final size and fill in the cartridge header and checksums
+void rom_finalize(ihx_context * ctx) {
+
+    rom_image * p_rom = &ctx->rom;
+    rom_options * p_opts = &ctx->rom_opts;
+    uint32_t size = ROM_SIZE_MIN;
+    uint32_t c;
+    uint8_t  header_sum = 0;
+    uint16_t global_sum = 0;
+    uint8_t  size_code = 0;
+
+    // Smallest power of two that holds everything written and the requested bank count
+    while (size < p_rom->used_end)
+        size *= 2;
+    if ((p_opts->rom_banks > 0) && (p_opts->rom_banks * BANK_SIZE > size)) {
+        while (size < p_opts->rom_banks * BANK_SIZE)
+            size *= 2;
+    } else if ((p_opts->rom_banks > 0) && (size > p_opts->rom_banks * BANK_SIZE))
+        context_printf(ctx, "Warning: ROM: data uses %d banks, more than -yo %d. ROM size increased to %d banks\n",
+                       (p_rom->used_end + BANK_SIZE - 1) / BANK_SIZE, p_opts->rom_banks, size / BANK_SIZE);
+    if (size > p_rom->size)
+        rom_grow(p_rom, size - 1);
+    p_rom->size = size;
+
+    // Title first, the CGB flag shares its last byte
+    if (p_opts->title[0] != '\0') {
+        memset(p_rom->data + HEADER_TITLE, 0, HEADER_TITLE_LEN);
+        memcpy(p_rom->data + HEADER_TITLE, p_opts->title, strlen(p_opts->title));
+    }
+    if (p_opts->cgb != ROM_OPT_UNSET)
+        p_rom->data[HEADER_CGB] = p_opts->cgb;
+    if (p_opts->licensee[0] != '\0') {
+        p_rom->data[HEADER_LICENSEE]     = p_opts->licensee[0];
+        p_rom->data[HEADER_LICENSEE + 1] = p_opts->licensee[1];
+    }
+    if (p_opts->sgb) {
+        p_rom->data[HEADER_SGB] = 0x03;
+        if (p_opts->old_licensee == ROM_OPT_UNSET)
+            p_rom->data[HEADER_OLD_LICENSEE] = OLD_LICENSEE_USE_NEW;
+    }
+    if (p_opts->cart_type != ROM_OPT_UNSET)
+        p_rom->data[HEADER_CART_TYPE] = p_opts->cart_type;
+    if (p_opts->ram_banks != ROM_OPT_UNSET)
+        p_rom->data[HEADER_RAM_SIZE] = rom_ram_size_code(ctx, p_opts->ram_banks);
+    if (p_opts->non_japanese)
+        p_rom->data[HEADER_DEST] = 0x01;
+    if (p_opts->old_licensee != ROM_OPT_UNSET)
+        p_rom->data[HEADER_OLD_LICENSEE] = p_opts->old_licensee;
+
+    // 32K << n
+    while ((ROM_SIZE_MIN << size_code) < size)
+        size_code++;
+    p_rom->data[HEADER_ROM_SIZE] = size_code;
+
+    for (c = 0; c < p_opts->patches_count; c++) {
+        if (p_opts->patches[c].address < size)
+            p_rom->data[p_opts->patches[c].address] = p_opts->patches[c].value;
+    }
+
+    // Header checksum over 0x134 - 0x14C, checked by the boot ROM
+    for (c = HEADER_TITLE; c < HEADER_CHECKSUM; c++)
+        header_sum = header_sum - p_rom->data[c] - 1;
+    p_rom->data[HEADER_CHECKSUM] = header_sum;
+
+    // Global checksum of every byte except itself
+    for (c = 0; c < size; c++)
+        global_sum += p_rom->data[c];
+    global_sum -= p_rom->data[HEADER_GLOBAL_SUM] + p_rom->data[HEADER_GLOBAL_SUM + 1];
+    p_rom->data[HEADER_GLOBAL_SUM]     = global_sum >> 8;
+    p_rom->data[HEADER_GLOBAL_SUM + 1] = global_sum & 0xFF;
+}
+
+
+int rom_file_write(ihx_context * ctx, char * filename_out) {
+
+    FILE * rom_file;
+    size_t written;
+
+    rom_finalize(ctx);
+
+    if ((rom_file = fopen(filename_out, "wb")) == NULL) {
+        context_printf(ctx, "Problem with filename or unable to open file! %s\n", filename_out);
+        return false;
+    }
+    written = fwrite(ctx->rom.data, 1, ctx->rom.size, rom_file);
+    if ((fclose(rom_file) != 0) || (written != ctx->rom.size)) {
+        context_printf(ctx, "Error: failed writing %s\n", filename_out);
+        remove(filename_out);
+        return false;
+    }
+    return true;
+}
+
+
+void rom_cleanup(ihx_context * ctx) {
+    if (ctx->rom.data)
+        free(ctx->rom.data);
+    ctx->rom.data = NULL;
+    ctx->rom.size = ctx->rom.used_end = 0;
+}
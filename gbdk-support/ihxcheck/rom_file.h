@@ -0,0 +1,51 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+// bbbbbr 2020
+
+#ifndef _ROM_FILE_H
+#define _ROM_FILE_H
+
+#define ROM_SIZE_MIN    0x8000U                 // 32K, two banks
+#define ROM_SIZE_MAX    (8U * 1024U * 1024U)    // 8MB, 512 banks (MBC5)
+#define ROM_FILL_VALUE  0xFFU
+
+#define ROM_OPT_UNSET   -1
+
+typedef struct rom_patch {
+    uint32_t address;
+    uint8_t  value;
+} rom_patch;
+
+// Cartridge header options, same as makebin -Z
+typedef struct rom_options {
+    int32_t     rom_banks;      // -yo n, 0 or -yo A for automatic
+    int32_t     ram_banks;      // -ya n
+    int32_t     cart_type;      // -yt n
+    int32_t     cgb;            // -yc (0x80) or -yC (0xC0)
+    bool        sgb;            // -ys
+    bool        non_japanese;   // -yj
+    int32_t     old_licensee;   // -yl hh
+    char        licensee[3];    // -yk cc
+    char        title[17];      // -yn name
+    rom_patch * patches;        // -yp addr=value
+    uint32_t    patches_count;
+} rom_options;
+
+typedef struct rom_image {
+    uint8_t *   data;
+    uint32_t    size;       // Allocated size, always a power of two
+    uint32_t    used_end;   // One past the highest address written
+} rom_image;
+
+
+struct ihx_context;
+
+void rom_options_init(rom_options * p_opts);
+int  rom_option(struct ihx_context * ctx, int argc, char * argv[], int * p_argn);
+void rom_init(struct ihx_context * ctx);
+void rom_write(struct ihx_context * ctx, uint32_t address, const uint8_t * p_data, uint32_t length);
+void rom_finalize(struct ihx_context * ctx);
+int  rom_file_write(struct ihx_context * ctx, char * filename_out);
+void rom_cleanup(struct ihx_context * ctx);
+
+#endif // _ROM_FILE_H
@@ -0,0 +1,436 @@
+/*
+ * Compile cache for lcc.
+ *
+ * Objects are stored under a key made from the preprocessed source,
+ * the expanded compile command line (less the output file) and the
+ * identity of the compiler binary. That input is stored with the
+ * object and compared on a hit, so a key collision is only a miss.
+ * On a hit the cached object and its listings are copied into place
+ * instead of running sdcc.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+# include <direct.h>
+# include <process.h>
+# include <io.h>
+# include <sys/locking.h>
+# include <sys/utime.h>
+# define mkdir(d, m) _mkdir(d)
+# define ftruncate(fd, n) _chsize(fd, n)
+#else
+# include <unistd.h>
+# include <utime.h>
+#endif
+#ifdef _MSC_VER
+# include <windows.h>
+#else
+# include <dirent.h>
+#endif
+
+#define CACHE_DEFAULT_SIZE	(64L * 1024 * 1024)
+
+extern char *progname;
+extern char *stringf(const char *, ...);
+extern char *strsave(const char *);
+extern void removeQuotes(char *, char *);
+extern char *sidecar(const char *, const char *);
+
+char *cachedir;				/* --cache-dir=dir or LCC_CACHE_DIR, 0 if disabled */
+static long cachelimit = CACHE_DEFAULT_SIZE;	/* --cache-size=n[k|M|G] */
+static int cachestats;			/* --cache-stats */
+static unsigned long hits, misses, stores;
+
+/* cachesize - parse a size with an optional k, M or G suffix */
+static long cachesize(const char *s) {
+	char *end;
+	long n = strtol(s, &end, 10);
+
+	switch (*end) {
+	case 'k': case 'K': n *= 1024L; break;
+	case 'm': case 'M': n *= 1024L * 1024; break;
+	case 'g': case 'G': n *= 1024L * 1024 * 1024; break;
+	}
+	return n;
+}
+
+/* cacheopt - process a --cache-* option, return 1 if it was one */
+int cacheopt(char *arg) {
+	if (strncmp(arg, "--cache-dir=", 12) == 0) {
+		cachedir = arg[12] ? arg + 12 : 0;
+		return 1;
+	}
+	else if (strncmp(arg, "--cache-size=", 13) == 0) {
+		cachelimit = cachesize(arg + 13);
+		return 1;
+	}
+	else if (strcmp(arg, "--cache-stats") == 0) {
+		cachestats++;
+		return 1;
+	}
+	return 0;
+}
+
+/* cacheinit - pick up LCC_CACHE_DIR/LCC_CACHE_SIZE and create the cache directory */
+void cacheinit(void) {
+	char *s, *p;
+
+	if (cachedir == 0 && (s = getenv("LCC_CACHE_DIR")) != 0 && *s)
+		cachedir = s;
+	if ((s = getenv("LCC_CACHE_SIZE")) != 0 && *s)
+		cachelimit = cachesize(s);
+	if (cachedir == 0)
+		return;
+	cachedir = strsave(cachedir);
+	for (p = cachedir + 1; *p; p++)
+		if (*p == '/' || *p == '\\') {
+			char c = *p;
+			*p = '\0';
+			mkdir(cachedir, 0777);
+			*p = c;
+		}
+	mkdir(cachedir, 0777);
+}
+
+/* Two independent 64 bit hashes, concatenated into a 128 bit key.
+   The key only names the entry: a hit also needs the stored input to match */
+typedef struct {
+	uint64_t a, b;
+	uint64_t len;
+} hash_t;
+
+static void hashinit(hash_t *h) {
+	h->a = 0xcbf29ce484222325ULL;	/* FNV-1a offset basis */
+	h->b = 0x6a09e667f3bcc908ULL;
+	h->len = 0;
+}
+
+static void hashbytes(hash_t *h, const void *data, size_t n) {
+	const unsigned char *p = data;
+
+	h->len += n;
+	while (n--) {
+		h->a = (h->a ^ *p) * 0x100000001b3ULL;	/* FNV-1a prime */
+		h->b = (h->b ^ *p++) * 0x9e3779b97f4a7c15ULL;
+		h->b ^= h->b >> 29;
+	}
+}
+
+/* cachekey - append the compile command av and the compiler identity to the
+   preprocessed file ifile, hash the result and return the key, or 0 */
+char *cachekey(char *av[], char *ofile, char *ifile) {
+	char buf[4096];
+	struct stat st;
+	size_t n;
+	hash_t h;
+	FILE *f;
+	int i;
+
+	if ((f = fopen(ifile, "ab")) == NULL)
+		return 0;
+	/* The output file name doesn't change the object, everything else may */
+	for (i = 0; av[i]; i++)
+		if (strcmp(av[i], ofile) != 0)
+			fwrite(av[i], 1, strlen(av[i]) + 1, f);	/* include the terminator as a separator */
+
+	/* A different compiler binary gives a different key */
+	if (strlen(av[0]) < sizeof buf) {
+		removeQuotes(av[0], strcpy(buf, av[0]));
+		if (stat(buf, &st) == 0)
+			fprintf(f, "%ld %ld\n", (long)st.st_size, (long)st.st_mtime);
+	}
+	if (fclose(f) != 0 || (f = fopen(ifile, "rb")) == NULL)
+		return 0;
+	hashinit(&h);
+	while ((n = fread(buf, 1, sizeof buf, f)) > 0)
+		hashbytes(&h, buf, n);
+	fclose(f);
+	return stringf("%016llx%016llx", (unsigned long long)(h.a ^ h.len),
+		(unsigned long long)h.b);
+}
+
+/* copyfile - copy src to dst, return 1 on success */
+static int copyfile(const char *src, const char *dst) {
+	char buf[4096];
+	size_t n;
+	FILE *in, *out;
+	int ok = 1;
+
+	if ((in = fopen(src, "rb")) == NULL)
+		return 0;
+	if ((out = fopen(dst, "wb")) == NULL) {
+		fclose(in);
+		return 0;
+	}
+	while ((n = fread(buf, 1, sizeof buf, in)) > 0)
+		if (fwrite(buf, 1, n, out) != n) {
+			ok = 0;
+			break;
+		}
+	fclose(in);
+	if (fclose(out) != 0)
+		ok = 0;
+	if (!ok)
+		remove(dst);
+	return ok;
+}
+
+/* samefile - return 1 if files a and b have the same contents */
+static int samefile(const char *a, const char *b) {
+	char abuf[4096], bbuf[4096];
+	size_t n;
+	FILE *fa, *fb;
+	int same = 0;
+
+	if ((fa = fopen(a, "rb")) == NULL)
+		return 0;
+	if ((fb = fopen(b, "rb")) != NULL) {
+		do {
+			n = fread(abuf, 1, sizeof abuf, fa);
+			same = fread(bbuf, 1, sizeof bbuf, fb) == n && memcmp(abuf, bbuf, n) == 0;
+		} while (same && n > 0);
+		fclose(fb);
+	}
+	fclose(fa);
+	return same;
+}
+
+/* The files of a cache entry: the object, its input, then the files kept next
+   to the object: debug info, and the compiler and assembler listings */
+static char *entryfiles[] = { ".o", ".i", ".adb", ".asm", ".lst", ".sym", 0 };
+static char **sidecars = entryfiles + 2;
+
+/* cachefetch - copy the object cached under key to ofile, return 1 on a hit;
+   ifile is the input the key was made from, which must match the stored one */
+int cachefetch(char *key, char *ofile, char *ifile) {
+	char *obj = stringf("%s/%s.o", cachedir, key);
+	char *in = stringf("%s/%s.i", cachedir, key);
+	int i;
+
+	if (!samefile(ifile, in) || !copyfile(obj, ofile)) {
+		misses++;
+		return 0;
+	}
+	/* Keep recently used entries when trimming */
+	utime(in, NULL);
+	utime(obj, NULL);
+	for (i = 0; sidecars[i]; i++) {
+		char *src = stringf("%s/%s%s", cachedir, key, sidecars[i]);
+		char *dst = sidecar(ofile, sidecars[i]);
+		/* Don't leave another compile's file next to the object */
+		if (copyfile(src, dst))
+			utime(src, NULL);
+		else
+			remove(dst);
+	}
+	hits++;
+	return 1;
+}
+
+/* cacheput - move the temporary file tmp into the cache as name, return 1 on success */
+static int cacheput(char *tmp, char *name) {
+	remove(name);
+	if (rename(tmp, name) == 0)
+		return 1;
+	remove(tmp);
+	return 0;
+}
+
+/* cachestore - add the freshly compiled ofile, made from ifile, to the cache under key */
+void cachestore(char *key, char *ofile, char *ifile) {
+	char *tmp = stringf("%s/%s.%d.tmp", cachedir, key, (int)getpid());
+	int i;
+
+	/* Write everything else first so a visible object always has it */
+	for (i = 0; sidecars[i]; i++) {
+		char *name = stringf("%s/%s%s", cachedir, key, sidecars[i]);
+		if (copyfile(sidecar(ofile, sidecars[i]), tmp))
+			cacheput(tmp, name);
+		else
+			remove(name);
+	}
+	if (copyfile(ifile, tmp) && cacheput(tmp, stringf("%s/%s.i", cachedir, key))
+		&& copyfile(ofile, tmp) && cacheput(tmp, stringf("%s/%s.o", cachedir, key)))
+		stores++;
+}
+
+/* cachejob - in a job process, forget the counts inherited from lcc (file 0)
+   or write the counts of this job to file for cachemerge */
+void cachejob(char *file) {
+	FILE *f;
+
+	if (file == 0)
+		hits = misses = stores = 0;
+	else if ((f = fopen(file, "w")) != NULL) {
+		fprintf(f, "%lu %lu %lu\n", hits, misses, stores);
+		fclose(f);
+	}
+}
+
+/* cachemerge - add the counts a job wrote to file */
+void cachemerge(char *file) {
+	unsigned long h, m, s;
+	FILE *f;
+
+	if ((f = fopen(file, "r")) == NULL)
+		return;
+	if (fscanf(f, "%lu %lu %lu", &h, &m, &s) == 3) {
+		hits += h;
+		misses += m;
+		stores += s;
+	}
+	fclose(f);
+	remove(file);
+}
+
+typedef struct {
+	char *name;
+	long size;
+	time_t mtime;
+} entry_t;
+
+static int entrycmp(const void *a, const void *b) {
+	const entry_t *x = a, *y = b;
+
+	return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+/* cachescan - list the files in the cache directory, return their count */
+static int cachescan(entry_t **list, long *total) {
+	int n = 0, max = 0;
+	struct stat st;
+	char *name;
+#ifdef _MSC_VER
+	WIN32_FIND_DATAA fd;
+	HANDLE d = FindFirstFileA(stringf("%s/*", cachedir), &fd);
+
+	if (d == INVALID_HANDLE_VALUE)
+		return 0;
+	do {
+		name = fd.cFileName;
+#else
+	struct dirent *e;
+	DIR *d = opendir(cachedir);
+
+	if (d == NULL)
+		return 0;
+	while ((e = readdir(d)) != NULL) {
+		name = e->d_name;
+#endif
+		if (name[0] == '.' || strcmp(name, "stats") == 0)
+			continue;
+		name = stringf("%s/%s", cachedir, name);
+		if (stat(name, &st) != 0)
+			continue;
+		if (n == max) {
+			max = max ? max * 2 : 256;
+			*list = realloc(*list, max * sizeof **list);
+		}
+		(*list)[n].name = name;
+		(*list)[n].size = (long)st.st_size;
+		(*list)[n].mtime = st.st_mtime;
+		*total += (long)st.st_size;
+		n++;
+#ifdef _MSC_VER
+	} while (FindNextFileA(d, &fd));
+	FindClose(d);
+#else
+	}
+	closedir(d);
+#endif
+	return n;
+}
+
+/* cacheremove - remove name and the rest of the cache entry it belongs to, return the bytes freed */
+static long cacheremove(char *name) {
+	char *stem = sidecar(name, "");
+	struct stat st;
+	long freed = 0;
+	int i;
+
+	if (stat(name, &st) == 0 && remove(name) == 0)
+		freed += (long)st.st_size;
+	for (i = 0; entryfiles[i]; i++) {
+		char *other = stringf("%s%s", stem, entryfiles[i]);
+		if (stat(other, &st) == 0 && remove(other) == 0)
+			freed += (long)st.st_size;
+	}
+	return freed;
+}
+
+/* statslock - wait for the lock on the open stats file fd, return 1 once it is held */
+static int statslock(int fd) {
+#ifdef _WIN32
+	return _locking(fd, _LK_LOCK, 1) == 0;
+#else
+	struct flock fl;
+
+	memset(&fl, 0, sizeof fl);
+	fl.l_type = F_WRLCK;
+	fl.l_whence = SEEK_SET;
+	while (fcntl(fd, F_SETLKW, &fl) == -1)
+		if (errno != EINTR)
+			return 0;
+	return 1;
+#endif
+}
+
+/* cachefinish - trim the cache to its size limit and update the statistics */
+void cachefinish(void) {
+	unsigned long total_hits = 0, total_misses = 0;
+	char buf[128], *s;
+	entry_t *list = NULL;
+	long size = 0;
+	int i, n, fd;
+
+	if (cachedir == 0)
+		return;
+
+	/* Drop the least recently used entries until below 90% of the limit */
+	n = cachescan(&list, &size);
+	if (size > cachelimit) {
+		qsort(list, n, sizeof *list, entrycmp);
+		for (i = 0; i < n && size > cachelimit / 10 * 9; i++)
+			size -= cacheremove(list[i].name);
+	}
+	free(list);
+
+	/* Other lcc runs may share the cache, so update the totals under a lock */
+	fd = open(stringf("%s/stats", cachedir), O_RDWR | O_CREAT, 0666);
+	if (fd >= 0 && statslock(fd)) {
+		n = read(fd, buf, sizeof buf - 1);
+		buf[n > 0 ? n : 0] = '\0';
+		if (sscanf(buf, "hits %lu misses %lu", &total_hits, &total_misses) != 2)
+			total_hits = total_misses = 0;
+		total_hits += hits;
+		total_misses += misses;
+		if (hits || misses) {
+			s = stringf("hits %lu\nmisses %lu\n", total_hits, total_misses);
+			lseek(fd, 0, SEEK_SET);
+			if (write(fd, s, strlen(s)) == (int)strlen(s))
+				ftruncate(fd, strlen(s));
+		}
+#ifdef _WIN32
+		lseek(fd, 0, SEEK_SET);
+		_locking(fd, _LK_UNLCK, 1);
+#endif
+	}
+	if (fd >= 0)
+		close(fd);
+
+	if (cachestats) {
+		fprintf(stderr, "%s: cache directory %s\n", progname, cachedir);
+		fprintf(stderr, "%s: cache hits   %lu (total %lu)\n", progname, hits, total_hits);
+		fprintf(stderr, "%s: cache misses %lu (total %lu), %lu stored\n", progname, misses, total_misses, stores);
+		fprintf(stderr, "%s: cache size   %ld kB of %ld kB\n", progname, size / 1024, cachelimit / 1024);
+	}
+}
@@ -0,0 +1,110 @@
+/*
+ * Make dependency files for lcc --incremental.
+ *
+ * Reads the rules written by the preprocessor for -MD and decides
+ * whether an object still matches its source, its headers and the
+ * command line it was compiled with, kept in a comment after the rule.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#define COMMAND "# lcc: "	/* the comment holding the compile command */
+
+/* newer - return 1 if file name is missing or was not modified before t */
+static int newer(const char *name, time_t t) {
+	struct stat st;
+
+	/* Within the same second the order isn't known, so rebuild */
+	return stat(name, &st) != 0 || st.st_mtime >= t;
+}
+
+/* command - read the rest of a comment from f, return 1 if it records the command cmd */
+static int command(FILE *f, const char *cmd) {
+	const char *p = COMMAND + 1;	/* the '#' was read */
+	int c, same = 1, tag = 1;
+
+	while ((c = getc(f)) != EOF && c != '\n') {
+		if (tag && *p == '\0') {
+			p = cmd;
+			tag = 0;
+		}
+		if (same && c == *p)
+			p++;
+		else
+			same = 0;
+	}
+	return same && !tag && *p == '\0';
+}
+
+/* depcommand - record the compile command cmd in dfile for uptodate */
+void depcommand(char *dfile, char *cmd) {
+	FILE *f;
+
+	if ((f = fopen(dfile, "a")) != NULL) {
+		fprintf(f, "%s%s\n", COMMAND, cmd);
+		fclose(f);
+	}
+}
+
+/* uptodate - return 1 if ofile exists, is newer than every dependency listed
+   in dfile and was compiled with the command cmd recorded there */
+int uptodate(char *ofile, char *dfile, char *cmd) {
+	char name[1024];
+	struct stat st;
+	int c, n = 0, deps = 0, stale = 0, rule = 0, samecmd = 0;
+	FILE *f;
+
+	if (stat(ofile, &st) != 0 || (f = fopen(dfile, "r")) == NULL)
+		return 0;
+
+	/* target: dep dep \
+	     dep ...
+	   Spaces in names are escaped with a backslash, a backslash at
+	   the end of a line continues the rule. The target is skipped,
+	   its ':' is the first one followed by white space. A '#' starts
+	   a comment to the end of the line. */
+	while (!stale) {
+		c = getc(f);
+		if (c == '\\') {
+			c = getc(f);
+			if (c == '\n' || c == '\r')
+				continue;
+			if (c != ' ' && c != '#' && c != ':') {
+				ungetc(c, f);
+				c = '\\';
+			}
+		}
+		else if (c == EOF || c == '#' || isspace(c)) {
+			if (n > 0) {
+				name[n] = '\0';
+				n = 0;
+				if (!rule) {
+					/* "target:" or "target :" */
+					if (strcmp(name, ":") == 0 || name[strlen(name) - 1] == ':')
+						rule = 1;
+				}
+				else if (newer(name, st.st_mtime))
+					stale = 1;
+				else
+					deps++;
+			}
+			if (c == '#' && command(f, cmd))
+				samecmd = 1;
+			if (c == EOF)
+				break;
+			continue;
+		}
+		if (n < (int)sizeof name - 1)
+			name[n++] = c;
+	}
+	fclose(f);
+
+	/* No dependencies found: don't trust the rule */
+	return !stale && deps > 0 && samecmd;
+}
@@ -230,6 +230,7 @@ char inputs[256] = "";
 char *cpp[256];
 char *include[256];
 char *com[256] = { "", "", "" };
+char *compp[256];
 char *as[256];
 char *ld[256];
 char *ihxcheck[256];
@@ -303,12 +304,26 @@ void finalise(void)
 	buildArgs(cpp, _class->cpp);
 	buildArgs(include, _class->include);
 	buildArgs(com, _class->com);
+	if (strstr(_class->com, "%comflag%")) {
+		/* Same command line, but only preprocess. Used by the compile cache */
+		char *comflag = getTokenVal("comflag");
+		setTokenVal("comflag", "-E");
+		buildArgs(compp, _class->com);
+		setTokenVal("comflag", comflag);
+	}
 	buildArgs(as, _class->as);
 	buildArgs(ld, _class->ld);
 	buildArgs(ihxcheck, _class->ihxcheck);
 	buildArgs(mkbin, _class->mkbin);
 }
 
+/* romwriter - return 1 if the ROM can be written in-process instead of by makebin -Z */
+int romwriter(void)
+{
+	/* The built in writer only knows the Game Boy cartridge header */
+	return _class == &classes[0];
+}
+
 void set_gbdk_dir(char* argv_0)
 {
 	char buf[1024 - 2]; // Path will get quoted below, so reserve two characters for them
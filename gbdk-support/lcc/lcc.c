@@ -11,6 +11,7 @@ static char rcsid[] = "$Id: lcc.c,v 1.6 2001/10/28 18:38:13 michaelh Exp $";
 #include <assert.h>
 #include <ctype.h>
 #include <signal.h>
+#include <errno.h>
 
 #ifdef _WIN32
 # include <io.h>
@@ -19,7 +20,10 @@ static char rcsid[] = "$Id: lcc.c,v 1.6 2001/10/28 18:38:13 michaelh Exp $";
 # include <unistd.h>
 # include <sys/types.h>
 # include <sys/wait.h>
+# include <sys/time.h>
+# include <sys/resource.h>
 #endif
+#include <fcntl.h>
 
 #ifndef TEMPDIR
 #define TEMPDIR "/tmp"
@@ -35,20 +39,32 @@ static void *alloc(int);
 List append(char *, List);
 extern char *basepath(char *);
 static int callsys(char *[]);
+static int callsysq(char *[]);
+static int cachesys(char *[], char *[], char *, char *);
+static char **cmdsave(char *[]);
+static char *cmdline(char *[]);
+static int ihxsys(char *[]);
+static int romopts(List);
 extern char *concat(const char *, const char *);
 static void compose(char *[], List, List, List);
 static void error(char *, char *);
 static char *exists(char *);
 static char *first(char *);
 static int filename(char *, char *);
+static List depflags(char *);
 static List find(char *, List);
 static void help(void);
 static void initinputs(void);
 static void interrupt(int);
+static int jobsys(char *[], char *[], char *, char *);
+static void jobflush(void);
+static void jobkill(void);
+static void jobwait(int);
 static void opt(char *);
 static List path2list(const char *);
 extern int main(int, char *[]);
 extern char *replace(const char *, int, int);
+extern char *sidecar(const char *, const char *);
 static void rm(List);
 extern char *strsave(const char *);
 extern char *stringf(const char *, ...);
@@ -57,10 +73,34 @@ extern char *tempname(char *);
 
 static void Fixllist();
 
-extern char *cpp[], *include[], *com[], *as[], *ld[], *ihxcheck[], *mkbin[], inputs[], *suffixes[];
+extern char *cpp[], *include[], *com[], *compp[], *as[], *ld[], *ihxcheck[], *mkbin[], inputs[], *suffixes[];
 extern int option(char *);
+extern int romwriter(void);
 extern void set_gbdk_dir(char*);
 
+extern char *cachedir;
+extern int cacheopt(char *);
+extern void cacheinit(void);
+extern char *cachekey(char *[], char *, char *);
+extern int cachefetch(char *, char *, char *);
+extern void cachestore(char *, char *, char *);
+extern void cachejob(char *);
+extern void cachemerge(char *);
+extern void cachefinish(void);
+
+extern int uptodate(char *, char *, char *);
+extern void depcommand(char *, char *);
+
+extern char *tracefile;
+extern long childrss;
+extern int traceopt(char *);
+extern void traceinit(void);
+extern double traceclock(void);
+extern void traceevent(char *[], double, int);
+extern void tracefinish(int);
+
+extern int ihxcheck_main(int, char *[]);
+
 void finalise(void);
 
 static int errcnt;		/* number of errors */
@@ -68,7 +108,12 @@ static int Eflag;		/* -E specified */
 static int Sflag;		/* -S specified */
 static int cflag;		/* -c specified */
 static int Kflag;		/* -K specified */
+static int MDflag;		/* -MD specified */
+static int incremental;		/* --incremental specified */
+static char *depfile;		/* -MF file */
 static int verbose;		/* incremented for each -v */
+static int jobs = 1;		/* -j N: max parallel compile/assemble jobs */
+static char *banner;		/* file name header for the next job's output */
 static List ihxchecklist;   /* ihxcheck flags */
 static List mkbinlist;		/* loader files, flags */
 static List llist[2];		/* loader files, flags */
@@ -133,6 +178,45 @@ int main(int argc, char *argv[]) {
 				exit(8);
 			}
 		}
+		else if (strncmp(argv[i], "-MF", 3) == 0) {
+			if (argv[i][3])
+				depfile = &argv[i][3];
+			else if (++i < argc)
+				depfile = argv[i];
+			else {
+				error("unrecognized option `%s'", argv[i - 1]);
+				exit(8);
+			}
+			MDflag++;
+			continue;
+		}
+		else if (strncmp(argv[i], "-j", 2) == 0) {
+			char *end;
+			if (argv[i][2]) {
+				jobs = strtol(&argv[i][2], &end, 10);
+				if (*end) {
+					error("unrecognized option `%s'", argv[i]);
+					exit(8);
+				}
+			}
+			// Only a wholly numeric argument is the count, lcc -j 2d_map.c compiles 2d_map.c
+			else if (i + 1 < argc && isdigit(*argv[i + 1])
+				&& argv[i + 1][strspn(argv[i + 1], "0123456789")] == '\0')
+				jobs = atoi(argv[++i]);
+			else {
+#ifdef _SC_NPROCESSORS_ONLN
+				jobs = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+				jobs = 1;
+#endif
+			}
+			if (jobs < 1)
+				jobs = 1;
+#ifdef _WIN32
+			jobs = 1;	/* no fork(), always run jobs one at a time */
+#endif
+			continue;
+		}
 		else if (strcmp(argv[i], "-target") == 0) {
 			if (argv[i + 1] && *argv[i + 1] != '-')
 				i++;
@@ -150,8 +234,14 @@ int main(int argc, char *argv[]) {
 		fprintf(stderr, "%s: -o %s ignored\n", progname, outfile);
 		outfile = 0;
 	}
+	if (depfile && nf != 1) {
+		fprintf(stderr, "%s: -MF %s ignored\n", progname, depfile);
+		depfile = 0;
+	}
 	argv[j] = 0;
 	finalise();
+	cacheinit();
+	traceinit();
 	for (i = 0; include[i]; i++)
 		clist = append(include[i], clist);
 	if (ilist) {
@@ -169,13 +259,20 @@ int main(int argc, char *argv[]) {
 			char *name = exists(argv[i]);
 			if (name) {
 				if (strcmp(name, argv[i]) != 0
-					|| nf > 1 && suffix(name, suffixes, 3) >= 0)
-					fprintf(stderr, "%s:\n", name);
+					|| nf > 1 && suffix(name, suffixes, 3) >= 0) {
+					if (jobs > 1)
+						banner = name;	/* printed with the job's output */
+					else
+						fprintf(stderr, "%s:\n", name);
+				}
 				filename(name, 0);
+				if (banner)
+					jobsys(NULL, 0, 0, 0);	/* no job was started, keep the header in order */
 			}
 			else
 				error("can't find `%s'", argv[i]);
 		}
+	jobwait(0);
 
     // Perform Link stage unless some conditions prevent it
 	if (errcnt == 0 && !Eflag && !cflag && !Sflag && llist[1]) {
@@ -203,25 +300,49 @@ int main(int argc, char *argv[]) {
 		if (callsys(av))
 			errcnt++;
 
-		// ihxcheck (test for multiple writes to the same ROM address)
-		if (!Kflag) {
-			compose(ihxcheck, ihxchecklist, append(ihxFile, 0), 0);
-			if (callsys(av))
+		if (errcnt == 0 && !target_is_ihx && romwriter() && romopts(mkbinlist)) {
+			// ihxcheck and the .ihx -> .gb conversion in one pass over the .ihx,
+			// the ROM is only written if the checks pass (-K skips the checks)
+			List l = 0, b;
+			if ((b = ihxchecklist) != 0)
+				do {
+					b = b->link;
+					l = append(b->str, l);
+				} while (b != ihxchecklist);
+			if (Kflag)
+				l = append("-n", l);
+			l = append(stringf("-o%s", outfile), l);
+			if ((b = mkbinlist) != 0)
+				do {
+					b = b->link;
+					l = append(b->str, l);
+				} while (b != mkbinlist);
+			compose(ihxcheck, l, append(ihxFile, 0), 0);
+			if (ihxsys(av))
 				errcnt++;
-		}
+		} else {
+			// ihxcheck (test for multiple writes to the same ROM address)
+			if (!Kflag) {
+				compose(ihxcheck, ihxchecklist, append(ihxFile, 0), 0);
+				if (ihxsys(av))
+					errcnt++;
+			}
 
-		// No need to makebin (.ihx -> .gb) if .ihx is final target
-		if (!target_is_ihx)
-		{
-			if(errcnt == 0)
+			// No need to makebin (.ihx -> .gb) if .ihx is final target
+			if (!target_is_ihx)
 			{
-				//makebin
-				compose(mkbin, mkbinlist, append(ihxFile, 0), append(outfile, 0));
-				if (callsys(av))
-					errcnt++;
+				if(errcnt == 0)
+				{
+					//makebin
+					compose(mkbin, mkbinlist, append(ihxFile, 0), append(outfile, 0));
+					if (callsys(av))
+						errcnt++;
+				}
 			}
 		}
 	}
+	cachefinish();
+	tracefinish(errcnt);
 	rm(rmlist);
 	return errcnt ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -331,6 +452,7 @@ char *basepath(char *name) {
 static int _spawnvp(int mode, const char *cmdname, char *argv[]) {
 	int status;
 	pid_t pid, n;
+	struct rusage ru;
 
 	switch (pid = fork()) {
 	case -1:
@@ -343,10 +465,18 @@ static int _spawnvp(int mode, const char *cmdname, char *argv[]) {
 		fflush(stdout);
 		exit(100);
 	}
-	while ((n = wait(&status)) != pid && n != -1)
+	/* only reap this child: -j jobs may still be running, and
+	   jobwait() needs their status */
+	while ((n = wait4(pid, &status, 0, &ru)) == -1 && errno == EINTR)
 		;
 	if (n == -1)
 		status = -1;
+	else
+#ifdef __APPLE__
+		childrss = ru.ru_maxrss / 1024;	/* bytes on macOS */
+#else
+		childrss = ru.ru_maxrss;	/* kB on Linux */
+#endif
 	if (status & 0377) {
 		fprintf(stderr, "%s: fatal error in %s\n", progname, cmdname);
 		status |= 0400;
@@ -447,7 +577,11 @@ static int callsys(char **av) {
 			//_spawnvp requires _FileName to not have quotes
 			//_Arguments must have quotes on windows, but not in macos
 			//Quoted strings must begin and end with quotes, no quotes in the middle
+			double start = tracefile ? traceclock() : 0;
+			childrss = 0;
 			status = _spawnvp(_P_WAIT, argv_0_no_quotes, argv);
+			if (tracefile)
+				traceevent(argv, start, status);
 		}
 		if (status == -1) {
 			fprintf(stderr, "%s: ", progname);
@@ -457,6 +591,290 @@ static int callsys(char **av) {
 	return status;
 }
 
+/* callsysq - callsys with the output of the commands discarded */
+static int callsysq(char **av) {
+#ifdef _WIN32
+	int fd = open("NUL", O_WRONLY);
+#else
+	int fd = open("/dev/null", O_WRONLY);
+#endif
+	int out, err, status;
+
+	if (fd < 0)
+		return callsys(av);
+	fflush(stdout);
+	fflush(stderr);
+	out = dup(1);
+	err = dup(2);
+	dup2(fd, 1);
+	dup2(fd, 2);
+	close(fd);
+	status = callsys(av);
+	fflush(stdout);
+	fflush(stderr);
+	dup2(out, 1);
+	dup2(err, 2);
+	close(out);
+	close(err);
+	return status;
+}
+
+/* romopts - return 1 if the makebin options are all header options the built in ROM writer handles */
+static int romopts(List list) {
+	List b = list;
+
+	/* The -y options ihxcheck's rom_option() implements, anything else goes to makebin */
+	if (b)
+		do {
+			b = b->link;
+			if (b->str[0] == '-' && (b->str[1] != 'y' || b->str[2] == '\0'
+				|| strchr("oatlknpcCsj", b->str[2]) == NULL))
+				return 0;
+		} while (b != list);
+	return 1;
+}
+
+/* ihxsys - run the ihxcheck command described by av[0...] in-process, return status */
+static int ihxsys(char **av) {
+	int i, status = 0;
+	char **argv;
+
+	for (i = 0; av[i] != NULL; i++)
+		;
+	argv = alloc((i + 1) * sizeof *argv);
+	for (i = 0; av[i] != NULL; i++) {
+		argv[i] = strsave(av[i]);
+		removeQuotes(argv[i], argv[i]);
+	}
+	argv[i] = NULL;
+	if (verbose > 0) {
+		fprintf(stderr, "%s", argv[0]);
+		for (i = 1; argv[i] != NULL; i++)
+			fprintf(stderr, " %s", argv[i]);
+		fprintf(stderr, " (built in)\n");
+	}
+	if (verbose < 2) {
+		double start = tracefile ? traceclock() : 0;
+		childrss = 0;
+		status = ihxcheck_main(i, argv);
+		fflush(stdout);
+		if (tracefile)
+			traceevent(argv, start, status);
+	}
+	return status;
+}
+
+/* cmdsave - return a copy of the command vector av[...], which the next compose overwrites */
+static char **cmdsave(char **av) {
+	char **copy;
+	int i;
+
+	for (i = 0; av[i] != NULL; i++)
+		;
+	copy = alloc((i + 1) * sizeof *copy);
+	for (i = 0; av[i] != NULL; i++)
+		copy[i] = strsave(av[i]);
+	copy[i] = NULL;
+	return copy;
+}
+
+/* cmdline - return the command av[...] as one line without quotes, to compare between runs */
+static char *cmdline(char **av) {
+	char *line = "", *arg, *s;
+	int i;
+
+	for (i = 0; av[i] != NULL; i++) {
+		arg = strsave(av[i]);
+		removeQuotes(arg, arg);
+		for (s = arg; *s; s++)
+			if (*s == '\n')
+				*s = ' ';
+		line = stringf(i ? "%s %s" : "%s%s", line, arg);
+	}
+	return line;
+}
+
+/* cachesys - execute the compile av[...] through the compile cache, return status;
+   pp[...] preprocesses the source into ifile for the key, ofile is the object */
+static int cachesys(char **pp, char **av, char *ifile, char *ofile) {
+	char *key = 0;
+	int status;
+
+	if (callsysq(pp) == 0)
+		key = cachekey(av, ofile, ifile);
+	if (key && cachefetch(key, ofile, ifile)) {
+		if (verbose > 0)
+			fprintf(stderr, "%s: cache hit for %s\n", progname, ofile);
+		return 0;
+	}
+	if ((status = callsys(av)) == 0 && key)
+		cachestore(key, ofile, ifile);
+	return status;
+}
+
+/* jobs - compile and assemble steps started in the background by -j */
+static struct job {
+	int pid;		/* running process, 0 once reaped */
+	int status;		/* exit status */
+	int killed;		/* stopped because another job failed */
+	char *banner;		/* file name header, or 0 */
+	char *out, *err;	/* captured stdout and stderr, or 0 */
+	char *tally;		/* compile cache counts of the job, or 0 */
+} *jobtab;
+static int njobs, nrunning, nflushed, jobfailed;
+
+/* jobsys - execute av[...] as a job when running in parallel, return status;
+   given pp[...], the compile goes through the compile cache, see cachesys */
+static int jobsys(char **av, char **pp, char *ifile, char *ofile) {
+#ifndef _WIN32
+	if (jobs > 1) {
+		struct job *j;
+		int fd;
+
+		jobwait(jobs - 1);
+		if (jobfailed) {	/* fail fast, start nothing new */
+			banner = 0;
+			return 0;
+		}
+		jobtab = realloc(jobtab, (njobs + 1) * sizeof *jobtab);
+		assert(jobtab);
+		j = &jobtab[njobs++];
+		j->pid = j->status = j->killed = 0;
+		j->banner = banner;
+		j->out = j->err = 0;
+		j->tally = 0;
+		banner = 0;
+		if (av == NULL) {
+			jobflush();
+			return 0;
+		}
+		j->out = tempname(".out");
+		j->err = tempname(".err");
+		if (pp)
+			j->tally = tempname(".tally");
+		fflush(stdout);
+		fflush(stderr);
+		switch (j->pid = fork()) {
+		case -1:
+			fprintf(stderr, "%s: no more processes\n", progname);
+			j->pid = 0;
+			j->status = 100;
+			jobfailed++;
+			errcnt++;
+			return 0;
+		case 0:
+			/* Own process group so a failing job can stop the others
+			   (and their sdcc children) without touching lcc itself */
+			setpgid(0, 0);
+			signal(SIGINT, SIG_DFL);
+			signal(SIGTERM, SIG_DFL);
+#ifdef SIGHUP
+			signal(SIGHUP, SIG_DFL);
+#endif
+			if ((fd = open(j->out, O_WRONLY | O_CREAT | O_TRUNC, 0644)) >= 0) {
+				dup2(fd, 1);
+				close(fd);
+			}
+			if ((fd = open(j->err, O_WRONLY | O_CREAT | O_TRUNC, 0644)) >= 0) {
+				dup2(fd, 2);
+				close(fd);
+			}
+			if (pp) {
+				cachejob(0);
+				fd = cachesys(pp, av, ifile, ofile);
+				cachejob(j->tally);
+			}
+			else
+				fd = callsys(av);
+			fflush(stdout);
+			_exit(fd);
+		}
+		setpgid(j->pid, j->pid);
+		nrunning++;
+		return 0;
+	}
+#endif
+	if (av == NULL)
+		return 0;
+	return pp ? cachesys(pp, av, ifile, ofile) : callsys(av);
+}
+
+/* jobwait - wait until at most n jobs are running, all of them once one has failed */
+static void jobwait(int n) {
+#ifndef _WIN32
+	while (nrunning > (jobfailed ? 0 : n)) {
+		int i, status;
+		pid_t pid = wait(&status);
+
+		if (pid == -1)
+			break;
+		for (i = 0; i < njobs && jobtab[i].pid != pid; i++)
+			;
+		if (i == njobs)
+			continue;
+		nrunning--;
+		jobtab[i].pid = 0;
+		if (WIFEXITED(status))
+			jobtab[i].status = WEXITSTATUS(status);
+		else {
+			if (!jobtab[i].killed)
+				fprintf(stderr, "%s: fatal error in job for %s\n", progname,
+					jobtab[i].banner ? jobtab[i].banner : "input");
+			jobtab[i].status = 0400 | WTERMSIG(status);
+		}
+		if (jobtab[i].tally)
+			cachemerge(jobtab[i].tally);
+		if (jobtab[i].status && !jobtab[i].killed) {
+			jobfailed++;
+			errcnt++;
+			jobkill();
+		}
+		jobflush();
+	}
+#endif
+}
+
+/* jobcat - copy the contents of file name to fp */
+static void jobcat(char *name, FILE *fp) {
+	char buf[1024];
+	size_t n;
+	FILE *f;
+
+	if (name == NULL || (f = fopen(name, "rb")) == NULL)
+		return;
+	while ((n = fread(buf, 1, sizeof buf, f)) > 0)
+		fwrite(buf, 1, n, fp);
+	fclose(f);
+	remove(name);
+}
+
+/* jobflush - print the output of finished jobs, in command line order */
+static void jobflush(void) {
+	for (; nflushed < njobs && jobtab[nflushed].pid == 0; nflushed++) {
+		struct job *j = &jobtab[nflushed];
+		if (j->killed)
+			continue;
+		if (j->banner)
+			fprintf(stderr, "%s:\n", j->banner);
+		jobcat(j->err, stderr);
+		jobcat(j->out, stdout);
+		fflush(stdout);
+	}
+}
+
+/* jobkill - stop all running jobs */
+static void jobkill(void) {
+#ifndef _WIN32
+	int i;
+
+	for (i = 0; i < njobs; i++)
+		if (jobtab[i].pid > 0) {
+			jobtab[i].killed = 1;
+			kill(-jobtab[i].pid, SIGTERM);
+		}
+#endif
+}
+
 /* concat - return concatenation of strings s1 and s2 */
 char *concat(const char *s1, const char *s2) {
 	int n = strlen(s1);
@@ -502,6 +920,21 @@ static void compose(char *cmd[], List a, List b, List c) {
 	av[j] = NULL;
 }
 
+/* depflags - preprocessor options from clist, plus those writing a make rule for target */
+static List depflags(char *target) {
+	List b, list = 0;
+
+	if (b = clist)
+		do {
+			b = b->link;
+			if (b->str[0] == '-' && b->str[1] && strchr("DUI", b->str[1]))
+				list = append(b->str, list);
+		} while (b != clist);
+	list = append("-M", list);
+	list = append("-MT", list);
+	return append(target, list);
+}
+
 /* error - issue error msg according to fmt, bump error count */
 static void error(char *fmt, char *msg) {
 	fprintf(stderr, "%s: ", progname);
@@ -561,11 +994,15 @@ static int filename(char *name, char *base) {
 	switch (suffix(name, suffixes, 4)) {
 	case 0:	/* C source files */
 		{
-			char *ofile;
+			char *ofile, *ifile = 0, *dfile = 0, **pp = 0;
 			if ((cflag || Sflag) && outfile)
 				ofile = outfile;
 			else if (cflag)
 				ofile = concat(base, first(suffixes[3]));
+			else if (incremental && !Sflag)
+				// Incremental builds keep their objects next to the sources
+				// to compare against next time, so a/util.c and b/util.c don't clash
+				ofile = sidecar(name, first(suffixes[3]));
 			else if (Sflag) {
 				// When compiling to asm only, set outfile as .asm
 				ofile = concat(base, ".asm");
@@ -581,8 +1018,45 @@ static int filename(char *name, char *base) {
 				rmlist = append(stringf("%s/%s%s", tempdir, ofileBase, ".adb"), rmlist);
 			}
 
+			if (MDflag || incremental && !Sflag) {
+				char *target = ofile, *cmd = 0;
+				if (depfile)
+					dfile = depfile;
+				else if (cflag || Sflag || incremental)
+					dfile = sidecar(ofile, ".d");
+				else {
+					// Objects are temporary, so the rule is for the linked output
+					dfile = sidecar(name, ".d");
+					target = outfile ? outfile : concat("a", first(suffixes[4]));
+				}
+				if (incremental && !Sflag) {
+					// Changed flags rebuild the object just like changed sources
+					compose(com, clist, append(name, 0), append(ofile, 0));
+					cmd = cmdline(av);
+					if (uptodate(ofile, dfile, cmd)) {
+						if (verbose > 0)
+							fprintf(stderr, "%s: %s is up to date\n", progname, ofile);
+						if (!find(ofile, llist[1]))
+							llist[1] = append(ofile, llist[1]);
+						break;
+					}
+					remove(ofile);	/* a failed compile must not leave an object that looks current */
+				}
+				compose(cpp, depflags(target), append(name, 0), append(dfile, 0));
+				if (callsysq(av) != 0)
+					remove(dfile);	/* the compile reports the errors, rebuild next time */
+				else if (cmd)
+					depcommand(dfile, cmd);
+			}
+
+			if (cachedir && !Sflag && compp[0] && verbose < 2) {
+				// Preprocessed for the cache key inside the job, see cachesys
+				ifile = tempname(".i");
+				compose(compp, clist, append(name, 0), append(ifile, 0));
+				pp = cmdsave(av);
+			}
 			compose(com, clist, append(name, 0), append(ofile, 0));
-			status = callsys(av);
+			status = jobsys(av, pp, ifile, ofile);
 			if (!find(ofile, llist[1]))
 				llist[1] = append(ofile, llist[1]);
 		}
@@ -599,7 +1073,7 @@ static int filename(char *name, char *base) {
 			else
 				ofile = tempname(first(suffixes[3]));
 			compose(as, alist, append(name, 0), append(ofile, 0));
-			status = callsys(av);
+			status = jobsys(av, 0, 0, 0);
 			if (!find(ofile, llist[1]))
 				llist[1] = append(ofile, llist[1]);
 		}
@@ -611,7 +1085,7 @@ static int filename(char *name, char *base) {
 	default:
 		if (Eflag) {
 			compose(cpp, plist, append(name, 0), 0);
-			status = callsys(av);
+			status = jobsys(av, 0, 0, 0);
 		}
 		llist[1] = append(name, llist[1]);
 		break;
@@ -646,14 +1120,21 @@ static void help(void) {
 #endif
 "-Bdir/	use the compiler named `dir/rcc'\n",
 "-c	compile only\n",
+"--cache-dir=dir	reuse objects compiled earlier, kept in `dir'; also LCC_CACHE_DIR\n",
+"--cache-size=n	limit the compile cache to `n' bytes (k, M, G suffixes); default 64M\n",
+"--cache-stats	print compile cache statistics\n",
 "-dn	set switch statement density to `n'\n",
 "-Dname -Dname=def	define the preprocessor symbol `name'\n",
 "-E	run only the preprocessor on the named C programs and unsuffixed files\n",
 "-g	produce symbol table information for debuggers\n",
 "-help or -?	print this message\n",
 "-Idir	add `dir' to the beginning of the list of #include directories\n",
+"--incremental	don't recompile C files whose object is newer than all of its dependencies\n",
+"-j [n]	run up to `n' compile and assemble jobs at once; default is one per CPU\n",
 "-K don't run ihxcheck test on linker ihx output\n",
 "-lx	search library `x'\n",
+"-MD	write the make dependencies of each C file to a .d file next to its object or source\n",
+"-MF file	like -MD, but write the make dependencies to `file'\n",
 "-N	do not search the standard directories for #include files\n",
 "-n	emit code to check for dereferencing zero pointers\n",
 "-O	is ignored\n",
@@ -667,6 +1148,7 @@ static void help(void) {
 "-t -tname	emit function tracing calls to printf or to `name'\n",
 "-target name	is ignored\n",
 "-tempdir=dir	place temporary files in `dir/'", "\n"
+"--trace=file	write a Chrome trace of the time spent in each command to `file'\n",
 "-Uname	undefine the preprocessor symbol `name'\n",
 "-v	show commands as they are executed; 2nd -v suppresses execution\n",
 "-w	suppress warnings\n",
@@ -724,6 +1206,7 @@ static void initinputs(void) {
 
 /* interrupt - catch interrupt signals */
 static void interrupt(int n) {
+	jobkill();
 	rm(rmlist);
 	exit(n = 100);
 }
@@ -787,6 +1270,20 @@ static void opt(char *arg) {
 			}
 		fprintf(stderr, "%s: %s ignored\n", progname, arg);
 		return;
+	case '-':	/* --incremental --cache-dir=dir --cache-size=n --cache-stats --trace=file */
+		if (strcmp(arg, "--incremental") == 0) {
+			incremental++;
+			return;
+		}
+		if (cacheopt(arg) || traceopt(arg))
+			return;
+		break;
+	case 'M':	/* -MD */
+		if (strcmp(arg, "-MD") == 0) {
+			MDflag++;
+			return;
+		}
+		break;
 	case 'd':	/* -dn */
 		arg[1] = 's';
 		clist = append(arg, clist);
@@ -962,6 +1459,20 @@ static void rm(List list) {
 	}
 }
 
+/* sidecar - return a copy of name with its suffix replaced by ext, e.g. foo.o => foo.d */
+char *sidecar(const char *name, const char *ext) {
+	const char *s, *dot = 0;
+
+	for (s = name; *s; s++)
+		if (*s == '/' || *s == '\\')
+			dot = 0;
+		else if (*s == '.')
+			dot = s;
+	if (dot == 0)
+		dot = s;
+	return stringf("%.*s%s", (int)(dot - name), name, ext);
+}
+
 /* strsave - return a saved copy of string str */
 char *strsave(const char *str) {
 	return strcpy(alloc(strlen(str) + 1), str);
@@ -0,0 +1,178 @@
+/*
+ * Build timing trace for lcc --trace=file.json.
+ *
+ * Every command run by callsys() becomes a complete ("X") event in
+ * the Chrome trace event format, which chrome://tracing and Perfetto
+ * load directly. Jobs started with -j append their own events to the
+ * same file, so each event is written with a single write() to a file
+ * opened for appending.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+
+#ifdef _WIN32
+# include <io.h>
+# include <process.h>
+# include <windows.h>
+#else
+# include <unistd.h>
+# include <sys/time.h>
+#endif
+
+extern char *progname;
+extern char *basepath(char *);
+
+char *tracefile;		/* --trace=file, 0 if disabled */
+long childrss;			/* peak RSS of the last command in kB, 0 if unknown */
+static int tracefd = -1;
+static int tracepid;		/* lcc itself, jobs use their own pid as thread id */
+static double tracestart;
+
+typedef struct {
+	char *s;
+	size_t n, max;
+} buffer_t;
+
+static void put(buffer_t *b, const char *s, size_t n) {
+	if (b->n + n + 1 > b->max) {
+		b->max = (b->n + n + 1) * 2;
+		b->s = realloc(b->s, b->max);
+	}
+	memcpy(b->s + b->n, s, n);
+	b->n += n;
+	b->s[b->n] = '\0';
+}
+
+static void putstr(buffer_t *b, const char *s) {
+	put(b, s, strlen(s));
+}
+
+/* putjson - append s as the contents of a JSON string, dropping any quotes around paths */
+static void putjson(buffer_t *b, const char *s) {
+	char esc[8];
+
+	for (; *s; s++)
+		if (*s == '"')
+			continue;
+		else if (*s == '\\')
+			put(b, "\\\\", 2);
+		else if ((unsigned char)*s < 0x20) {
+			sprintf(esc, "\\u%04x", (unsigned char)*s);
+			putstr(b, esc);
+		}
+		else
+			put(b, s, 1);
+}
+
+/* traceclock - wall clock time in microseconds */
+double traceclock(void) {
+#ifdef _WIN32
+	FILETIME ft;
+	unsigned long long t;
+
+	GetSystemTimeAsFileTime(&ft);
+	t = ((unsigned long long)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+	return t / 10.0;	/* 100 ns units */
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1e6 + tv.tv_usec;
+#endif
+}
+
+/* traceopt - process --trace=file, return 1 if it was that option */
+int traceopt(char *arg) {
+	if (strncmp(arg, "--trace=", 8) == 0) {
+		tracefile = arg[8] ? arg + 8 : 0;
+		return 1;
+	}
+	return 0;
+}
+
+/* traceinit - start the trace file */
+void traceinit(void) {
+	static const char head[] = "[\n";
+
+	if (tracefile == 0)
+		return;
+	tracefd = open(tracefile, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+	if (tracefd < 0) {
+		fprintf(stderr, "%s: can't write trace to %s\n", progname, tracefile);
+		tracefile = 0;
+		return;
+	}
+	tracepid = getpid();
+	tracestart = traceclock();
+	write(tracefd, head, sizeof head - 1);
+}
+
+/* traceinput - return the first argument naming a source, object list or ihx file */
+static char *traceinput(char *argv[]) {
+	static char *tails[] = { ".c", ".i", ".s", ".asm", ".ihx", 0 };
+	int i, j;
+
+	for (i = 1; argv[i]; i++) {
+		size_t len = strlen(argv[i]);
+		if (argv[i][0] == '-')
+			continue;
+		for (j = 0; tails[j]; j++) {
+			size_t m = strlen(tails[j]);
+			if (len > m && strcmp(argv[i] + len - m, tails[j]) == 0)
+				return argv[i];
+		}
+	}
+	return "";
+}
+
+/* traceevent - record that command argv ran from start until now with exit status */
+void traceevent(char *argv[], double start, int status) {
+	double end = traceclock();
+	buffer_t b = { 0, 0, 0 };
+	char num[128];
+	char *stage;
+	int i;
+
+	if (tracefd < 0)
+		return;
+	stage = basepath(argv[0]);
+	putstr(&b, "{\"name\":\"");
+	putjson(&b, stage);
+	putstr(&b, "\",\"cat\":\"lcc\",\"ph\":\"X\"");
+	sprintf(num, ",\"ts\":%.0f,\"dur\":%.0f,\"pid\":%d,\"tid\":%d", start, end - start, tracepid, (int)getpid());
+	putstr(&b, num);
+	putstr(&b, ",\"args\":{\"input\":\"");
+	putjson(&b, traceinput(argv));
+	sprintf(num, "\",\"status\":%d", status);
+	putstr(&b, num);
+	if (childrss > 0) {
+		sprintf(num, ",\"max_rss_kb\":%ld", childrss);
+		putstr(&b, num);
+	}
+	putstr(&b, ",\"command\":\"");
+	for (i = 0; argv[i]; i++) {
+		if (i)
+			put(&b, " ", 1);
+		putjson(&b, argv[i]);
+	}
+	putstr(&b, "\"}},\n");
+	write(tracefd, b.s, b.n);
+	free(b.s);
+}
+
+/* tracefinish - add an event for the whole run and close the trace */
+void tracefinish(int errcnt) {
+	char buf[256];
+
+	if (tracefd < 0)
+		return;
+	sprintf(buf, "{\"name\":\"lcc\",\"cat\":\"lcc\",\"ph\":\"X\",\"ts\":%.0f,\"dur\":%.0f,"
+		"\"pid\":%d,\"tid\":%d,\"args\":{\"errors\":%d}}\n]\n",
+		tracestart, traceclock() - tracestart, tracepid, tracepid, errcnt);
+	write(tracefd, buf, strlen(buf));
+	close(tracefd);
+	tracefd = -1;
+}
@@ -0,0 +1,466 @@
+// This is free and unencumbered software released into the public domain.
+// For more information, please refer to <https://unlicense.org>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ihx_file.h"
+#include "banks.h"
+#include "rom_file.h"
+#include "context.h"
+
+// Compares two builds of a ROM one 16K bank at a time, so that a
+// flasher only has to rewrite the banks that changed.
+//
+// Either build can be a .ihx (turned into the same image lcc/makebin
+// would write, using the -y header options given) or a finished .gb.
+//
+// Bank list file (-b), all values little endian:
+//   "GBBANKS\0"                 : 8 byte signature
+//   uint32 rom_size             : Size of the new ROM in bytes
+//   uint32 count                : Number of banks that follow
+//   count * {
+//     uint16 bank               : Bank number
+//     uint8  data[16384]        : Full contents of the bank in the new ROM,
+//   }                           : padded with 0xFF past its end
+//
+// IPS file (-i): Standard IPS, with RLE records for long runs of the
+// same byte and the truncation extension when the new ROM is smaller.
+
+#define EXIT_DIFFERENT  1
+#define EXIT_ERROR      2
+
+#define BANKLIST_SIG        "GBBANKS"   // Terminator makes it 8 bytes
+#define IPS_RECORD_MAX      0xFFFFU
+#define IPS_OFFSET_EOF      0x454F46U   // "EOF", can't be used as a record offset
+#define IPS_RECORD_OVERHEAD 5U          // Merge changes closer than this into one record
+#define IPS_RLE_MIN         9U          // Shortest run worth an RLE record
+
+// Global checksum, may be ignored with -g
+#define HEADER_GLOBAL_SUM   0x14EU
+
+typedef struct bank_diff {
+    uint32_t changed;   // Bytes that differ
+    uint32_t first;     // Address of the first and last change
+    uint32_t last;
+} bank_diff;
+
+static void display_help(void);
+static int handle_args(int argc, char * argv[]);
+
+ihx_context rom_old;
+ihx_context rom_new;
+char * filename_old = NULL;
+char * filename_new = NULL;
+char * filename_ips = NULL;
+char * filename_banks = NULL;
+bool option_ignore_global_sum = false;
+bool option_quiet = false;
+
+
+static void display_help(void) {
+    fprintf(stdout,
+           "romdiff old.[ihx|gb] new.[ihx|gb] [options]\n"
+           "\n"
+           "Options\n"
+           "-h : Show this help\n"
+           "-i <file.ips> : Write an IPS patch from the old ROM to the new one\n"
+           "-b <file> : Write the changed banks with their contents (bank list)\n"
+           "-g : Ignore changes to the global checksum (not checked by the hardware),\n"
+           "     so bank 0 is only rewritten when its contents change\n"
+           "-q : Don't list the changed banks\n"
+           "-yo, -ya, -yt, ... : Header options for .ihx inputs, same as makebin -Z\n"
+           "\n"
+           "Use: Compare two builds bank by bank and list the 16K banks that changed.\n"
+           "     Exits with 0 if the ROMs match, 1 if they differ and 2 on errors.\n"
+           "Example: \"romdiff old/MyProject.gb build/MyProject.ihx -yt 0x1B -yo A -b MyProject.banks\"\n"
+           );
+}
+
+
+static int handle_args(int argc, char * argv[]) {
+
+    int i;
+
+    if( argc < 3 ) {
+        display_help();
+        return false;
+    }
+
+    // Start at first optional argument, argc is zero based
+    for (i = 1; i <= (argc -1); i++ ) {
+
+        if (argv[i][0] != '-') {
+            if (filename_old == NULL)
+                filename_old = argv[i];
+            else if (filename_new == NULL)
+                filename_new = argv[i];
+            else {
+                printf("Error: more than two input files given: %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(argv[i], "-i") == 0) {
+            if (i + 1 < argc)
+                filename_ips = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0) {
+            if (i + 1 < argc)
+                filename_banks = argv[++i];
+        } else if (strcmp(argv[i], "-g") == 0) {
+            option_ignore_global_sum = true;
+        } else if (strcmp(argv[i], "-q") == 0) {
+            option_quiet = true;
+        } else if (argv[i][1] == 'y') {
+            // Same header options for both, so the images match what the build wrote
+            if (!rom_option(&rom_new, argc, argv, &i)) {
+                printf("Error: unknown ROM option %s\n", argv[i]);
+                return false;
+            }
+        } else if (strstr(argv[i], "-h")) {
+            display_help();
+            return false;  // Don't parse input when -h is used
+        }
+    }
+
+    if ((filename_old == NULL) || (filename_new == NULL)) {
+        printf("Error: need an old and a new ROM to compare\n");
+        return false;
+    }
+
+    rom_old.rom_opts = rom_new.rom_opts;
+    return true;
+}
+
+
+static int matches_extension(char * filename, char * extension) {
+    return (strlen(filename) >= strlen(extension)) &&
+           (strcmp(filename + (strlen(filename) - strlen(extension)), extension) == 0);
+}
+
+
+// Read a finished ROM as is
+static bool rom_load_binary(ihx_context * ctx, char * filename) {
+
+    FILE * rom_file = fopen(filename, "rb");
+    long size;
+
+    if (!rom_file) {
+        printf("Problem with filename or unable to open file! %s\n", filename);
+        return false;
+    }
+
+    fseek(rom_file, 0, SEEK_END);
+    size = ftell(rom_file);
+    fseek(rom_file, 0, SEEK_SET);
+
+    if ((size <= 0) || (size > ROM_SIZE_MAX)) {
+        printf("Error: %s is not a ROM (size %ld)\n", filename, size);
+        fclose(rom_file);
+        return false;
+    }
+
+    ctx->rom.data = (uint8_t *)malloc(size);
+    ctx->rom.size = ctx->rom.used_end = (uint32_t)size;
+    if (fread(ctx->rom.data, 1, size, rom_file) != (size_t)size) {
+        printf("Error: unable to read %s\n", filename);
+        fclose(rom_file);
+        return false;
+    }
+    fclose(rom_file);
+    return true;
+}
+
+
+// Build the image from a .ihx with the regular parser, or read a .gb
+static bool rom_load(ihx_context * ctx, char * filename) {
+
+    if (matches_extension(filename, (char *)".ihx")) {
+        // Overlaps are ihxcheck's job, only the image is needed here
+        ctx->option_no_checks = true;
+        ctx->rom_in_memory = true;
+        return (ihx_file_process_areas(ctx, filename) == EXIT_SUCCESS) && (ctx->rom.data != NULL);
+    }
+
+    return rom_load_binary(ctx, filename);
+}
+
+
+// Size of the larger ROM
+static uint32_t rom_size_max(void) {
+    return (rom_old.rom.size > rom_new.rom.size) ? rom_old.rom.size : rom_new.rom.size;
+}
+
+
+static void bank_compare(uint32_t bank, bank_diff * p_diff) {
+
+    uint32_t address = bank * BANK_SIZE;
+    uint32_t end = address + BANK_SIZE;
+
+    // The last bank may be partial
+    if (end > rom_size_max())
+        end = rom_size_max();
+
+    p_diff->changed = 0;
+    for (; address < end; address++) {
+        if (option_ignore_global_sum &&
+            ((address == HEADER_GLOBAL_SUM) || (address == HEADER_GLOBAL_SUM + 1)))
+            continue;
+        // Banks only in one of the ROMs are changed as a whole
+        if ((address >= rom_old.rom.size) || (address >= rom_new.rom.size) ||
+            (rom_old.rom.data[address] != rom_new.rom.data[address])) {
+            if (p_diff->changed++ == 0)
+                p_diff->first = address;
+            p_diff->last = address;
+        }
+    }
+}
+
+
+static void write_u16(FILE * out_file, uint16_t value) {
+    fputc(value & 0xFF, out_file);
+    fputc(value >> 8, out_file);
+}
+
+
+static void write_u32(FILE * out_file, uint32_t value) {
+    write_u16(out_file, value & 0xFFFF);
+    write_u16(out_file, value >> 16);
+}
+
+
+static bool banklist_write(char * filename, bank_diff * diffs, uint32_t bank_count) {
+
+    FILE * out_file = fopen(filename, "wb");
+    uint32_t bank;
+    uint32_t count = 0;
+    uint32_t length;
+
+    if (!out_file) {
+        printf("Error: unable to write %s\n", filename);
+        return false;
+    }
+
+    // Banks that only exist in the old ROM are dropped by the new size
+    for (bank = 0; bank < bank_count; bank++)
+        if ((diffs[bank].changed != 0) && (bank * BANK_SIZE < rom_new.rom.size))
+            count++;
+
+    fwrite(BANKLIST_SIG, 1, sizeof(BANKLIST_SIG), out_file);
+    write_u32(out_file, rom_new.rom.size);
+    write_u32(out_file, count);
+
+    for (bank = 0; bank < bank_count; bank++) {
+        if ((diffs[bank].changed == 0) || (bank * BANK_SIZE >= rom_new.rom.size))
+            continue;
+        write_u16(out_file, bank);
+        length = rom_new.rom.size - bank * BANK_SIZE;
+        if (length > BANK_SIZE)
+            length = BANK_SIZE;
+        fwrite(rom_new.rom.data + bank * BANK_SIZE, 1, length, out_file);
+        for (; length < BANK_SIZE; length++)
+            fputc(0xFF, out_file);
+    }
+
+    return (fclose(out_file) == 0);
+}
+
+
+static void ips_write_offset(FILE * out_file, uint32_t offset) {
+    fputc((offset >> 16) & 0xFF, out_file);
+    fputc((offset >> 8) & 0xFF, out_file);
+    fputc(offset & 0xFF, out_file);
+}
+
+
+// Length of the run of identical bytes at address, up to length
+static uint32_t ips_run_length(uint32_t address, uint32_t length) {
+
+    uint8_t value = rom_new.rom.data[address];
+    uint32_t run = 1;
+
+    while ((run < length) && (rom_new.rom.data[address + run] == value))
+        run++;
+    return run;
+}
+
+
+// Plain record of new ROM bytes, moved a byte early if it would
+// start at the offset that reads as "EOF" (the byte is rewritten
+// with the value it has in the new ROM, so that is harmless)
+static void ips_write_record(FILE * out_file, uint32_t offset, uint32_t length) {
+
+    if (offset == IPS_OFFSET_EOF) {
+        offset--;
+        length++;
+    }
+    ips_write_offset(out_file, offset);
+    fputc(length >> 8, out_file);
+    fputc(length & 0xFF, out_file);
+    fwrite(rom_new.rom.data + offset, 1, length, out_file);
+}
+
+
+// Write new ROM bytes start .. end - 1, as RLE records for long runs
+// and plain records for the rest
+static void ips_write_span(FILE * out_file, uint32_t start, uint32_t end) {
+
+    uint32_t address = start;
+    uint32_t literal = start;
+    uint32_t run;
+    uint32_t length;
+
+    while (address < end) {
+        run = ips_run_length(address, end - address);
+
+        // RLE can't be moved like a plain record, so never start one at "EOF"
+        if ((run < IPS_RLE_MIN) || (address == IPS_OFFSET_EOF)) {
+            address++;
+            continue;
+        }
+
+        // Flush pending plain bytes before the run
+        for (; literal < address; literal += length) {
+            length = address - literal;
+            if (length > IPS_RECORD_MAX - 1)
+                length = IPS_RECORD_MAX - 1;
+            ips_write_record(out_file, literal, length);
+        }
+
+        if (run > IPS_RECORD_MAX)
+            run = IPS_RECORD_MAX;
+        ips_write_offset(out_file, address);
+        fputc(0, out_file);
+        fputc(0, out_file);
+        fputc(run >> 8, out_file);
+        fputc(run & 0xFF, out_file);
+        fputc(rom_new.rom.data[address], out_file);
+        address += run;
+        literal = address;
+    }
+
+    for (; literal < end; literal += length) {
+        length = end - literal;
+        if (length > IPS_RECORD_MAX - 1)
+            length = IPS_RECORD_MAX - 1;
+        ips_write_record(out_file, literal, length);
+    }
+}
+
+
+static bool ips_write(char * filename, bank_diff * diffs, uint32_t bank_count) {
+
+    FILE * out_file = fopen(filename, "wb");
+    uint32_t bank;
+    uint32_t address;
+    uint32_t end;
+    uint32_t span_start = 0;
+    uint32_t span_end = 0;
+    bool in_span = false;
+
+    if (!out_file) {
+        printf("Error: unable to write %s\n", filename);
+        return false;
+    }
+
+    fwrite("PATCH", 1, 5, out_file);
+
+    for (bank = 0; bank < bank_count; bank++) {
+        if ((diffs[bank].changed == 0) || (bank * BANK_SIZE >= rom_new.rom.size))
+            continue;
+
+        // Only bytes which differ (all of them past the end of the old ROM),
+        // joining changes too close together to be worth a new record
+        end = diffs[bank].last + 1;
+        if (end > rom_new.rom.size)
+            end = rom_new.rom.size;  // The rest is cut by the truncation extension
+        for (address = diffs[bank].first; address < end; address++) {
+            if ((address < rom_old.rom.size) && (rom_old.rom.data[address] == rom_new.rom.data[address]))
+                continue;
+            if (option_ignore_global_sum &&
+                ((address == HEADER_GLOBAL_SUM) || (address == HEADER_GLOBAL_SUM + 1)))
+                continue;
+
+            if (in_span && (address - span_end <= IPS_RECORD_OVERHEAD))
+                span_end = address + 1;
+            else {
+                if (in_span)
+                    ips_write_span(out_file, span_start, span_end);
+                span_start = address;
+                span_end = address + 1;
+                in_span = true;
+            }
+        }
+    }
+    if (in_span)
+        ips_write_span(out_file, span_start, span_end);
+
+    fwrite("EOF", 1, 3, out_file);
+
+    // Truncation extension
+    if (rom_new.rom.size < rom_old.rom.size)
+        ips_write_offset(out_file, rom_new.rom.size);
+
+    return (fclose(out_file) == 0);
+}
+
+
+int main( int argc, char *argv[] )  {
+
+    int ret = EXIT_ERROR;
+    uint32_t bank_count;
+    uint32_t bank;
+    uint32_t changed_count = 0;
+    uint32_t changed_bytes = 0;
+    bank_diff * diffs;
+
+    context_init(&rom_old);
+    context_init(&rom_new);
+    ihx_file_init();
+
+    if (handle_args(argc, argv) &&
+        rom_load(&rom_old, filename_old) &&
+        rom_load(&rom_new, filename_new)) {
+
+        // A last partial bank counts as a bank
+        bank_count = (rom_size_max() + BANK_SIZE - 1) / BANK_SIZE;
+        diffs = (bank_diff *)calloc(bank_count, sizeof(bank_diff));
+
+        for (bank = 0; bank < bank_count; bank++) {
+            bank_compare(bank, &diffs[bank]);
+            if (diffs[bank].changed == 0)
+                continue;
+
+            changed_count++;
+            changed_bytes += diffs[bank].changed;
+            if (option_quiet)
+                continue;
+
+            if (bank * BANK_SIZE >= rom_new.rom.size)
+                printf("Bank %3d: removed\n", bank);
+            else if (bank * BANK_SIZE >= rom_old.rom.size)
+                printf("Bank %3d: added\n", bank);
+            else
+                printf("Bank %3d: %5d bytes changed (0x%06x - 0x%06x)\n",
+                       bank, diffs[bank].changed, diffs[bank].first, diffs[bank].last);
+        }
+
+        printf("%d of %d banks changed, %d bytes\n", changed_count, bank_count, changed_bytes);
+        if (rom_old.rom.size != rom_new.rom.size)
+            printf("ROM size changed from %d to %d bytes\n", rom_old.rom.size, rom_new.rom.size);
+
+        ret = (changed_count || (rom_old.rom.size != rom_new.rom.size)) ? EXIT_DIFFERENT : EXIT_SUCCESS;
+
+        if (filename_ips && !ips_write(filename_ips, diffs, bank_count))
+            ret = EXIT_ERROR;
+        if (filename_banks && !banklist_write(filename_banks, diffs, bank_count))
+            ret = EXIT_ERROR;
+
+        free(diffs);
+    }
+
+    context_cleanup(&rom_old);
+    context_cleanup(&rom_new);
+    return ret;
+}